@@ -0,0 +1,89 @@
+/*
+    This file is part of the Kushview Modules for JUCE
+    Copyright (c) 2014-2019  Kushview, LLC.  All rights reserved.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+class ArcListTests : public UnitTest
+{
+public:
+    ArcListTests() : UnitTest ("ArcList") { }
+
+    void runTest() override
+    {
+        beginTest ("sorted and unique");
+        OwnedArray<Arc> arcs;
+        Random random (91);
+        for (int i = 0; i < 500; ++i)
+            arcs.add (new Arc ((uint32) random.nextInt (20), (uint32) random.nextInt (3),
+                               (uint32) random.nextInt (20), (uint32) random.nextInt (3)));
+
+        ArcList list (arcs);
+        ArcList incremental;
+        for (auto* arc : arcs)
+            incremental.add (arc->sourceNode, arc->sourcePort, arc->destNode, arc->destPort);
+
+        expectEquals (list.size(), incremental.size());
+        bool sorted = true;
+        for (int i = 0; i < list.size(); ++i)
+        {
+            sorted = sorted && list[i] == incremental[i];
+            if (i > 0)
+                sorted = sorted && ArcSorter::compareElements (list[i - 1], list[i]) < 0;
+        }
+        expect (sorted);
+
+        for (auto* arc : arcs)
+        {
+            const ArcData data = { arc->sourceNode, arc->sourcePort, arc->destNode, arc->destPort };
+            expect (list.contains (data));
+        }
+
+        beginTest ("arcs from and to a node");
+        bool found = true;
+        for (uint32 node = 0; node < 21; ++node)
+        {
+            int numFrom = 0, numTo = 0;
+            for (const auto& arc : list)
+            {
+                numFrom += arc.sourceNode == node ? 1 : 0;
+                numTo   += arc.destNode == node ? 1 : 0;
+            }
+
+            const Range<int> from (list.getRangeFrom (node)), to (list.getRangeTo (node));
+            found = found && from.getLength() == numFrom && to.getLength() == numTo;
+            for (int i = from.getStart(); i < from.getEnd(); ++i)
+                found = found && list[i].sourceNode == node;
+            for (int i = to.getStart(); i < to.getEnd(); ++i)
+                found = found && list.getArcTo (i).destNode == node;
+        }
+        expect (found);
+
+        beginTest ("remove");
+        const ArcData first = list[0];
+        expect (list.remove (first));
+        expect (! list.remove (first));
+        expect (! list.contains (first));
+
+        list.removeNode (3);
+        expect (list.getRangeFrom (3).isEmpty());
+        expect (list.getRangeTo (3).isEmpty());
+        for (const auto& arc : list)
+            expect (arc.sourceNode != 3 && arc.destNode != 3);
+    }
+};
+
+static ArcListTests sArcListTests;
@@ -0,0 +1,264 @@
+/*
+    This file is part of the Kushview Modules for JUCE
+    Copyright (c) 2014-2019  Kushview, LLC.  All rights reserved.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/** The arc table as it was before it kept a topological order, used to
+    check results and as the benchmark baseline */
+class RecursiveArcTable
+{
+public:
+    explicit RecursiveArcTable (const OwnedArray<Arc>& arcs)
+    {
+        for (auto* arc : arcs)
+        {
+            const int index = findEntry (arc->destNode);
+            Entry* entry = index >= 0 ? entries.getUnchecked (index) : nullptr;
+            if (entry == nullptr)
+                entries.add (entry = new Entry (arc->destNode));
+            entry->srcNodes.add (arc->sourceNode);
+        }
+    }
+
+    bool isAnInputTo (const uint32 input, const uint32 dest) const
+    {
+        return isAnInputToRecursive (input, dest, entries.size());
+    }
+
+private:
+    struct Entry
+    {
+        explicit Entry (uint32 d) : destNode (d) { }
+        const uint32 destNode;
+        SortedSet<uint32> srcNodes;
+    };
+
+    OwnedArray<Entry> entries;
+
+    int findEntry (uint32 destNode) const
+    {
+        for (int i = 0; i < entries.size(); ++i)
+            if (entries.getUnchecked(i)->destNode == destNode)
+                return i;
+        return -1;
+    }
+
+    bool isAnInputToRecursive (uint32 input, uint32 dest, int recursionCheck) const
+    {
+        const int index = findEntry (dest);
+        if (index < 0)
+            return false;
+
+        const SortedSet<uint32>& srcNodes = entries.getUnchecked(index)->srcNodes;
+        if (srcNodes.contains (input))
+            return true;
+
+        if (--recursionCheck >= 0)
+            for (int i = 0; i < srcNodes.size(); ++i)
+                if (isAnInputToRecursive (input, srcNodes.getUnchecked (i), recursionCheck))
+                    return true;
+
+        return false;
+    }
+};
+
+class ArcTableTests : public UnitTest
+{
+public:
+    ArcTableTests() : UnitTest ("ArcTable") { }
+
+    enum { numNodes = 24 };
+
+    /** Plain reachability over a node adjacency matrix */
+    static bool reaches (const int counts[numNodes][numNodes], int from, int to)
+    {
+        bool seen [numNodes] = { false };
+        Array<int> stack;
+        for (int n = 0; n < numNodes; ++n)
+            if (counts[from][n] > 0)
+                stack.add (n);
+
+        while (stack.size() > 0)
+        {
+            const int node = stack.removeAndReturn (stack.size() - 1);
+            if (node == to)
+                return true;
+            if (seen [node])
+                continue;
+            seen [node] = true;
+            for (int n = 0; n < numNodes; ++n)
+                if (counts[node][n] > 0 && ! seen [n])
+                    stack.add (n);
+        }
+
+        return false;
+    }
+
+    void runTest() override
+    {
+        beginTest ("matches a plain search as arcs come and go");
+        Random random (1234);
+        ArcTable<Arc> table;
+        int counts [numNodes][numNodes] = { { 0 } };
+        int numArcs = 0, errors = 0;
+
+        for (int step = 0; step < 4000; ++step)
+        {
+            const int source = random.nextInt (numNodes);
+            const int dest   = random.nextInt (numNodes);
+
+            // mostly forward arcs so the graph keeps coming back to a DAG
+            const bool allowCycle = random.nextInt (10) == 0;
+            if (random.nextInt (3) > 0 && (allowCycle || ! table.wouldCreateCycle (source, dest)))
+            {
+                const bool closesCycle = source == dest || reaches (counts, dest, source);
+                if (table.addArc (source, dest) == closesCycle)
+                    ++errors;
+                ++counts[source][dest];
+                ++numArcs;
+            }
+            else if (table.removeArc (source, dest) != (counts[source][dest] > 0))
+            {
+                ++errors;
+            }
+            else if (counts[source][dest] > 0)
+            {
+                --counts[source][dest];
+                --numArcs;
+            }
+
+            for (int i = 0; i < 8; ++i)
+            {
+                const int a = random.nextInt (numNodes), b = random.nextInt (numNodes);
+                if (table.isAnInputTo (a, b) != reaches (counts, a, b))
+                    ++errors;
+            }
+        }
+
+        expectEquals (errors, 0);
+        expectEquals (table.getNumArcs(), numArcs);
+
+        beginTest ("agrees with the old table");
+        OwnedArray<Arc> arcs;
+        for (int s = 0; s < numNodes; ++s)
+            for (int d = 0; d < numNodes; ++d)
+                if (counts[s][d] > 0 && random.nextInt (4) == 0)
+                    arcs.add (new Arc (s, 0, d, 0));
+
+        ArcTable<Arc> built (arcs);
+        RecursiveArcTable old (arcs);
+        errors = 0;
+        for (int a = 0; a < numNodes; ++a)
+            for (int b = 0; b < numNodes; ++b)
+                if (built.isAnInputTo (a, b) != old.isAnInputTo (a, b))
+                    ++errors;
+        expectEquals (errors, 0);
+
+        beginTest ("self loop");
+        ArcTable<Arc> loop;
+        expect (! loop.addArc (7, 7));
+        expect (loop.hasCycles());
+        expect (loop.removeArc (7, 7));
+        expectEquals (loop.getNumNodes(), 0);
+        expect (! loop.hasCycles());
+    }
+};
+
+static ArcTableTests sArcTableTests;
+
+/** Times the connect-time cycle check on a large patch graph: many tracks,
+    each a chain of effects into a few busses, then a master. Compares
+    rebuilding the old recursive table for every check with the incremental
+    table. Run it on its own with: UnitTests "ArcTable Benchmark" */
+class ArcTableBenchmark : public UnitTest
+{
+public:
+    ArcTableBenchmark() : UnitTest ("ArcTable Benchmark") { }
+
+    enum { numTracks = 200, chainLength = 8, numBusses = 8, numChecks = 200 };
+
+    static uint32 trackNode (int track, int slot) { return 1 + (uint32) (track * chainLength + slot); }
+    static uint32 busNode (int bus)               { return 1 + (uint32) (numTracks * chainLength + bus); }
+    static uint32 masterNode()                    { return busNode (numBusses); }
+
+    void runTest() override
+    {
+        beginTest ("connect time cycle check");
+
+        OwnedArray<Arc> arcs;
+        for (int t = 0; t < numTracks; ++t)
+        {
+            for (int s = 1; s < chainLength; ++s)
+                for (uint32 port = 0; port < 2; ++port)
+                    arcs.add (new Arc (trackNode (t, s - 1), port, trackNode (t, s), port));
+            arcs.add (new Arc (trackNode (t, chainLength - 1), 0, busNode (t % numBusses), 0));
+        }
+        for (int b = 0; b < numBusses; ++b)
+            arcs.add (new Arc (busNode (b), 0, masterNode(), 0));
+
+        // candidate connections: sends between tracks, some of them feedback
+        Random random (42);
+        Array<Arc> candidates;
+        for (int i = 0; i < numChecks; ++i)
+        {
+            const int t1 = random.nextInt (numTracks), t2 = random.nextInt (numTracks);
+            candidates.add (Arc (trackNode (t1, random.nextInt (chainLength)), 0,
+                                 random.nextBool() ? trackNode (t2, random.nextInt (chainLength))
+                                                   : busNode (random.nextInt (numBusses)), 0));
+        }
+
+        const double ticksPerMs = (double) Time::getHighResolutionTicksPerSecond() / 1000.0;
+        Array<bool> oldResults, newResults;
+
+        // before: the table is built from scratch for each check
+        int64 start = Time::getHighResolutionTicks();
+        for (const auto& c : candidates)
+        {
+            RecursiveArcTable table (arcs);
+            oldResults.add (c.sourceNode == c.destNode || table.isAnInputTo (c.destNode, c.sourceNode));
+        }
+        const double oldMs = (double) (Time::getHighResolutionTicks() - start) / ticksPerMs;
+
+        // after: the table is kept up to date as arcs are added and removed
+        start = Time::getHighResolutionTicks();
+        ArcTable<Arc> table (arcs);
+        const double buildMs = (double) (Time::getHighResolutionTicks() - start) / ticksPerMs;
+
+        start = Time::getHighResolutionTicks();
+        for (const auto& c : candidates)
+        {
+            const bool cycle = table.wouldCreateCycle (c.sourceNode, c.destNode);
+            newResults.add (cycle);
+
+            // connect, then disconnect again so every check sees the same graph
+            if (! cycle)
+            {
+                table.addArc (c.sourceNode, c.destNode);
+                table.removeArc (c.sourceNode, c.destNode);
+            }
+        }
+        const double newMs = (double) (Time::getHighResolutionTicks() - start) / ticksPerMs;
+
+        expect (oldResults == newResults);
+        logMessage (String (arcs.size()) + " arcs, " + String ((int) numChecks) + " checks");
+        logMessage (String ("rebuild + recursive (ms): ") + String (oldMs, 2));
+        logMessage (String ("incremental (ms): ") + String (newMs, 2)
+            + "  initial build " + String (buildMs, 2));
+    }
+};
+
+static ArcTableBenchmark sArcTableBenchmark;
@@ -0,0 +1,196 @@
+/*
+    This file is part of the Kushview Modules for JUCE
+    Copyright (c) 2014-2019  Kushview, LLC.  All rights reserved.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/** Stress tests for the lock-free primitives in Atomic.h. These are most
+    useful in a build with -fsanitize=thread */
+class AtomicTests : public UnitTest
+{
+public:
+    AtomicTests() : UnitTest ("Atomic") { }
+
+    /** Every field is derived from the counter, so a torn read shows up as a mismatch */
+    struct Snapshot
+    {
+        uint64 counter;
+        double position;
+        int32  bar, beat;
+        float  levels [9];
+
+        void fill (uint64 c)
+        {
+            counter = c;
+            position = (double) c * 0.5;
+            bar  = (int32) (c / 4);
+            beat = (int32) (c % 4);
+            for (int i = 0; i < 9; ++i)
+                levels[i] = (float) ((c + (uint64) i) % 1000);
+        }
+
+        bool isConsistent() const
+        {
+            // compare fields, the padding bytes aren't copied reliably
+            Snapshot expected;
+            expected.fill (counter);
+            if (position != expected.position || bar != expected.bar || beat != expected.beat)
+                return false;
+            for (int i = 0; i < 9; ++i)
+                if (levels[i] != expected.levels[i])
+                    return false;
+            return true;
+        }
+    };
+
+    struct Reader : public Thread
+    {
+        Reader (AtomicSnapshot<Snapshot>& s) : Thread ("reader"), snapshot (s) { }
+
+        void run() override
+        {
+            uint64 last = 0;
+            while (! threadShouldExit())
+            {
+                const Snapshot value (snapshot.get());
+                if (! value.isConsistent() || value.counter < last)
+                    ++errors;
+                last = value.counter;
+                ++reads;
+            }
+        }
+
+        AtomicSnapshot<Snapshot>& snapshot;
+        std::atomic<int> errors { 0 };
+        std::atomic<int> reads { 0 };
+    };
+
+    void runTest() override
+    {
+        testSeqLock();
+        testSnapshot();
+        testLock();
+    }
+
+    void testSeqLock()
+    {
+        beginTest ("seqlock tickets");
+
+        SeqLock seq;
+        uint32 ticket;
+        expect (seq.beginRead (ticket));
+        expect (seq.validate (ticket));
+        expectEquals ((int) SeqLock::versionOf (ticket), 0);
+
+        seq.beginWrite();
+        expect (! seq.validate (ticket), "a started write invalidates the ticket");
+        uint32 during;
+        expect (! seq.beginRead (during), "reads can't start during a write");
+        seq.endWrite();
+
+        expect (! seq.validate (ticket));
+        expect (seq.beginRead (ticket));
+        expect (seq.validate (ticket));
+        expectEquals ((int) SeqLock::versionOf (ticket), 1);
+        expectEquals ((int) seq.getVersion(), 1);
+    }
+
+    void testSnapshot()
+    {
+        beginTest ("snapshot single writer, many readers");
+
+        Snapshot initial;
+        initial.fill (0);
+        AtomicSnapshot<Snapshot> snapshot (initial);
+        expect (snapshot.get().isConsistent());
+
+        OwnedArray<Reader> readers;
+        for (int i = 0; i < 4; ++i)
+            readers.add (new Reader (snapshot))->startThread();
+
+        Snapshot value;
+        for (uint64 c = 1; c <= 200000; ++c)
+        {
+            value.fill (c);
+            snapshot.set (value);
+        }
+
+        for (auto* reader : readers)
+            reader->stopThread (1000);
+
+        expectEquals (snapshot.get().counter, (uint64) 200000);
+        expectEquals ((int) snapshot.getVersion(), 200001);
+        for (auto* reader : readers)
+        {
+            expect (reader->reads.load() > 0);
+            expectEquals (reader->errors.load(), 0);
+        }
+    }
+
+    struct Locker : public Thread
+    {
+        Locker (AtomicLock& l, int64& c) : Thread ("locker"), lock (l), counter (c) { }
+
+        void run() override
+        {
+            for (int i = 0; i < numIncrements; ++i)
+            {
+                lock.lock();
+                lock.lock();    // recursive
+                ++counter;
+                lock.unlock();
+                lock.unlock();
+            }
+        }
+
+        enum { numIncrements = 100000 };
+        AtomicLock& lock;
+        int64& counter;
+    };
+
+    void testLock()
+    {
+        beginTest ("lock");
+        AtomicLock lock;
+        expect (lock.acquire());
+        expect (lock.isBusy());
+        expect (! lock.acquire());
+        lock.release();
+        expect (! lock.isBusy());
+
+        beginTest ("lock under contention");
+        int64 counter = 0;
+        OwnedArray<Locker> lockers;
+        for (int i = 0; i < 8; ++i)
+            lockers.add (new Locker (lock, counter));
+        for (auto* locker : lockers)
+            locker->startThread();
+        for (auto* locker : lockers)
+            locker->waitForThreadToExit (-1);
+
+        lock.lock();
+        expectEquals (counter, (int64) (8 * Locker::numIncrements));
+        lock.unlock();
+        expect (! lock.isBusy());
+
+        const auto stats = lock.getStats();
+        expectEquals (stats.locks, (uint64) (8 * Locker::numIncrements + 1));
+        logMessage (String ("contended: ") + String ((int64) stats.contended)
+                    + "  parked: " + String ((int64) stats.parked));
+    }
+};
+
+static AtomicTests sAtomicTests;
@@ -0,0 +1,118 @@
+/*
+    This file is part of the Kushview Modules for JUCE
+    Copyright (c) 2014-2019  Kushview, LLC.  All rights reserved.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+
+class AudioRingBufferTests : public UnitTest
+{
+public:
+    AudioRingBufferTests() : UnitTest ("AudioRingBuffer") { }
+
+    /** Moves the fifo's read and write positions so the next write wraps */
+    static void advance (AudioRingBuffer<float>& fifo, int numFrames)
+    {
+        HeapBlock<float> scratch ((size_t) (numFrames * fifo.getNumChannels()));
+        zeromem (scratch.getData(), sizeof (float) * (size_t) (numFrames * fifo.getNumChannels()));
+        fifo.writeInterleaved (scratch.getData(), numFrames);
+        fifo.readInterleaved (scratch.getData(), numFrames);
+    }
+
+    template<typename SampleType>
+    void checkWrap (int numChannels, float scale, SampleType maxValue)
+    {
+        const int numFrames = 12;
+        AudioRingBuffer<float> fifo (numChannels, 16);
+        advance (fifo, 10);
+
+        // the write splits 6 + 6 across the end of the ring
+        Array<SampleType> frames;
+        for (int i = 0; i < numFrames * numChannels; ++i)
+            frames.add (static_cast<SampleType> (i % 2 == 0 ? maxValue - i : -maxValue + i));
+        fifo.writeInterleaved (frames.getRawDataPointer(), numFrames);
+        expectEquals (fifo.getNumReady(), numFrames);
+
+        // channels come out deinterleaved and scaled
+        OwnedArray<Array<float>> channels;
+        HeapBlock<float*> pointers ((size_t) numChannels);
+        for (int c = 0; c < numChannels; ++c)
+        {
+            Array<float>* const channel = channels.add (new Array<float>());
+            channel->insertMultiple (0, 0.0f, numFrames);
+            pointers[c] = channel->getRawDataPointer();
+        }
+
+        AudioRingBuffer<float> copy (numChannels, 16);
+        advance (copy, 10);
+        copy.writeInterleaved (frames.getRawDataPointer(), numFrames);
+        copy.readFromFifo (pointers.getData(), numFrames);
+
+        int errors = 0;
+        for (int f = 0; f < numFrames; ++f)
+            for (int c = 0; c < numChannels; ++c)
+                if (pointers[c][f] != static_cast<float> (frames[f * numChannels + c]) * scale)
+                    ++errors;
+        expectEquals (errors, 0);
+
+        // reading interleaved restores the converted frames in order
+        Array<float> out;
+        out.insertMultiple (0, 0.0f, numFrames * numChannels);
+        fifo.readInterleaved (out.getRawDataPointer(), numFrames);
+        expectEquals (fifo.getNumReady(), 0);
+
+        errors = 0;
+        for (int i = 0; i < out.size(); ++i)
+            if (out[i] != static_cast<float> (frames[i]) * scale)
+                ++errors;
+        expectEquals (errors, 0);
+    }
+
+    void runTest() override
+    {
+        beginTest ("stereo float wraps");
+        checkWrap<float> (2, 1.0f, 1.0f);
+
+        beginTest ("stereo int16 scaling");
+        checkWrap<int16> (2, 1.0f / 32768.0f, (int16) 32767);
+
+        beginTest ("stereo int32 scaling");
+        checkWrap<int32> (2, 1.0f / 2147483648.0f, (int32) 2147483647);
+
+        beginTest ("mono");
+        checkWrap<float> (1, 1.0f, 1.0f);
+        checkWrap<int16> (1, 1.0f / 32768.0f, (int16) 32767);
+
+        beginTest ("three channels");
+        checkWrap<float> (3, 1.0f, 1.0f);
+        checkWrap<int32> (3, 1.0f / 2147483648.0f, (int32) 2147483647);
+
+        beginTest ("full scale");
+        {
+            AudioRingBuffer<float> fifo (2, 8);
+            const int16 extremes[] = { -32768, 32767, 0, -1 };
+            fifo.writeInterleaved (extremes, 2);
+            float out[4] = {};
+            fifo.readInterleaved (out, 2);
+            expectEquals (out[0], -1.0f);
+            expectEquals (out[1], 32767.0f / 32768.0f);
+            expectEquals (out[2], 0.0f);
+            expectEquals (out[3], -1.0f / 32768.0f);
+        }
+    }
+};
+
+static AudioRingBufferTests sAudioRingBufferTests;
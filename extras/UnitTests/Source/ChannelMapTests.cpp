@@ -0,0 +1,126 @@
+/*
+    This file is part of the Kushview Modules for JUCE
+    Copyright (c) 2014-2019  Kushview, LLC.  All rights reserved.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+class ChannelMapTests : public UnitTest
+{
+public:
+    ChannelMapTests() : UnitTest ("ChannelMap") { }
+
+    void runTest() override
+    {
+        beginTest ("from port types");
+        {
+            // audio in x2, audio out x2, controls x3, midi in, midi out
+            Array<PortType> types;
+            Array<bool> inputs;
+            const int layout[] = { PortType::Audio, PortType::Audio, PortType::Audio, PortType::Audio,
+                                   PortType::Control, PortType::Control, PortType::Control,
+                                   PortType::Midi, PortType::Midi };
+            const bool isInput[] = { true, true, false, false, true, true, true, true, false };
+            for (int i = 0; i < 9; ++i)
+            {
+                types.add (layout[i]);
+                inputs.add (isInput[i]);
+            }
+
+            const ChannelMap map (types, inputs);
+            expectEquals ((int) map.getNumPorts(), 9);
+            expectEquals (map.getNumChannels (PortType::Audio, true), 2);
+            expectEquals (map.getNumChannels (PortType::Audio, false), 2);
+            expectEquals (map.getNumChannels (PortType::Control, true), 3);
+            expectEquals (map.getNumChannels (PortType::Control, false), 0);
+            expectEquals (map.getNumChannels (PortType::Midi, false), 1);
+            expectEquals (map.getNumChannels (PortType::Unknown, true), 0);
+
+            expectEquals (map.getPort (PortType::Audio, 1, false), (uint32) 3);
+            expectEquals (map.getPort (PortType::Control, 2, true), (uint32) 6);
+            expectEquals (map.getPort (PortType::Midi, 0, false), (uint32) 8);
+            expectEquals (map.getPort (PortType::Control, 0, false), KV_INVALID_PORT);
+            expectEquals (map.getPort (PortType::Audio, 2, true), KV_INVALID_PORT);
+            expectEquals (map.getPort (PortType::Audio, -1, true), KV_INVALID_PORT);
+
+            for (uint32 port = 0; port < map.getNumPorts(); ++port)
+            {
+                expect (map.getPortType (port) == types.getUnchecked ((int) port));
+                expect (map.isInput (port) == inputs [(int) port]);
+                expectEquals (map.getPort (map.getPortType (port), map.getChannel (port), map.isInput (port)), port);
+            }
+
+            expectEquals (map.getChannel (5), 1);
+            expectEquals (map.getChannel (100), KV_INVALID_CHANNEL);
+            expect (map.getPortType (100) == PortType::Unknown);
+            expectEquals (map.getPorts (PortType::Control, true)[1], (uint32) 5);
+        }
+
+        beginTest ("from channel config");
+        {
+            ChannelConfig config;
+            config.addInput  (PortType::Audio, 3);
+            config.addInput  (PortType::Audio, 1);
+            config.addOutput (PortType::Audio, 0);
+            config.addInput  (PortType::Atom, 2);
+
+            const ChannelMap map (config);
+            expectEquals ((int) map.getNumPorts(), 4);
+            expectEquals (map.getPort (PortType::Audio, 0, true), (uint32) 3);
+            expectEquals (map.getPort (PortType::Audio, 1, true), (uint32) 1);
+            expectEquals (map.getPort (PortType::Audio, 0, false), (uint32) 0);
+            expectEquals (map.getChannel (1), 1);
+            expect (map.isInput (2) && map.getPortType (2) == PortType::Atom);
+        }
+
+        beginTest ("from port list");
+        {
+            PortList list;
+            list.add (PortType::Audio, 0, 0, "in_1", "In 1", true);
+            list.add (PortType::Audio, 1, 0, "out_1", "Out 1", false);
+            list.addControl (2, 0, "gain", "Gain", 0.f, 1.f, 1.f, true);
+            list.add (PortType::Midi, 4, 0, "midi_in", "MIDI In", true);
+
+            const ChannelMap map (list);
+            expectEquals ((int) map.getNumPorts(), 5);
+            expectEquals (map.getPort (PortType::Midi, 0, true), (uint32) 4);
+            expectEquals (map.getChannel (3), KV_INVALID_CHANNEL);
+            expect (map.getPortType (3) == PortType::Unknown);
+            for (const auto* port : list)
+                expectEquals ((uint32) list.getPortForChannel (port->type, port->channel, port->input),
+                              map.getPort (port->type, port->channel, port->input));
+        }
+
+        beginTest ("swap");
+        {
+            Array<PortType> types;
+            Array<bool> inputs;
+            types.add (PortType::Audio);    inputs.add (true);
+            types.add (PortType::Audio);    inputs.add (false);
+            types.add (PortType::Audio);    inputs.add (false);
+
+            ChannelMap map;
+            ChannelMap built (types, inputs);
+            map.swapWith (built);
+            expectEquals ((int) map.getNumPorts(), 3);
+            expectEquals (map.getNumChannels (PortType::Audio, false), 2);
+            expectEquals (map.getPort (PortType::Audio, 1, false), (uint32) 2);
+            expectEquals ((int) built.getNumPorts(), 0);
+            expectEquals (built.getNumChannels (PortType::Audio, false), 0);
+        }
+    }
+};
+
+static ChannelMapTests sChannelMapTests;
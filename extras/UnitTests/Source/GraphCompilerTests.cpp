@@ -0,0 +1,112 @@
+/*
+    This file is part of the Kushview Modules for JUCE
+    Copyright (c) 2014-2019  Kushview, LLC.  All rights reserved.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+class GraphCompilerTests : public UnitTest
+{
+public:
+    GraphCompilerTests() : UnitTest ("GraphCompiler") { }
+
+    static void connect (OwnedArray<Arc>& arcs, uint32 source, uint32 dest, uint32 port = 0)
+    {
+        arcs.add (new Arc (source, port, dest, port));
+    }
+
+    /** Every arc that isn't a delay must go from an earlier wave to a later one */
+    bool isValidSchedule (const GraphCompiler& compiler, const OwnedArray<Arc>& arcs)
+    {
+        for (auto* arc : arcs)
+        {
+            const int sourceWave = compiler.getWaveOf (arc->sourceNode);
+            const int destWave   = compiler.getWaveOf (arc->destNode);
+            if (sourceWave < 0 || destWave < 0)
+                return false;
+            if (sourceWave >= destWave && ! compiler.isDelayArc (arc->sourceNode, arc->sourcePort,
+                                                                  arc->destNode, arc->destPort))
+                return false;
+        }
+
+        return true;
+    }
+
+    void runTest() override
+    {
+        beginTest ("diamond");
+        {
+            OwnedArray<Arc> arcs;
+            connect (arcs, 1, 2, 0); connect (arcs, 1, 2, 1);
+            connect (arcs, 1, 3);
+            connect (arcs, 2, 4); connect (arcs, 3, 4);
+
+            GraphCompiler compiler;
+            compiler.compile (arcs, Array<uint32> ({ 9 }));
+            expectEquals (compiler.getNumWaves(), 3);
+            expect (compiler.getWave (0) == Array<uint32> ({ 1, 9 }));
+            expect (compiler.getWave (1) == Array<uint32> ({ 2, 3 }));
+            expect (compiler.getWave (2) == Array<uint32> ({ 4 }));
+            expect (compiler.getOrder() == Array<uint32> ({ 1, 9, 2, 3, 4 }));
+            expect (! compiler.hasFeedback());
+            expectEquals (compiler.getWaveOf (5), -1);
+        }
+
+        beginTest ("feedback loops become delays");
+        {
+            OwnedArray<Arc> arcs;
+            connect (arcs, 1, 2);
+            connect (arcs, 2, 3);
+            connect (arcs, 3, 2, 0); connect (arcs, 3, 2, 1);
+            connect (arcs, 3, 4);
+            connect (arcs, 4, 4);
+
+            GraphCompiler compiler;
+            compiler.compile (arcs);
+            expectEquals (compiler.getDelayArcs().size(), 3);
+            expect (compiler.isDelayArc (3, 0, 2, 0));
+            expect (compiler.isDelayArc (3, 1, 2, 1));
+            expect (compiler.isDelayArc (4, 0, 4, 0));
+            expect (compiler.getOrder() == Array<uint32> ({ 1, 2, 3, 4 }));
+            expect (isValidSchedule (compiler, arcs));
+        }
+
+        beginTest ("random graphs");
+        {
+            Random random (5678);
+            bool valid = true;
+            for (int round = 0; round < 50; ++round)
+            {
+                OwnedArray<Arc> arcs;
+                const int numNodes = 2 + random.nextInt (40);
+                for (int i = random.nextInt (100); --i >= 0;)
+                    connect (arcs, (uint32) random.nextInt (numNodes), (uint32) random.nextInt (numNodes),
+                             (uint32) random.nextInt (2));
+
+                GraphCompiler compiler;
+                compiler.compile (arcs);
+                valid = valid && isValidSchedule (compiler, arcs);
+
+                int total = 0;
+                for (int w = 0; w < compiler.getNumWaves(); ++w)
+                    total += compiler.getWave (w).size();
+                valid = valid && total == compiler.getOrder().size();
+            }
+            expect (valid);
+        }
+    }
+};
+
+static GraphCompilerTests sGraphCompilerTests;
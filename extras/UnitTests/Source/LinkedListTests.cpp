@@ -0,0 +1,97 @@
+/*
+    This file is part of the Kushview Modules for JUCE
+    Copyright (c) 2014-2019  Kushview, LLC.  All rights reserved.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+class LinkedListTests : public UnitTest
+{
+public:
+    LinkedListTests() : UnitTest ("LinkedList") { }
+
+    struct Item : public LinkedList<Item>::Link
+    {
+        Item (int v) : value (v) { ++numLive; }
+        ~Item() { --numLive; }
+        int value;
+        static int numLive;
+    };
+
+    void runTest() override
+    {
+        beginTest ("nodes are recycled");
+        {
+            LinkedList<Item> list;
+            list.setScoped (true);
+            list.reserve (8, 0);
+            expectEquals (list.getNumFree(), 8);
+            expectEquals (Item::numLive, 8);
+
+            for (int i = 0; i < 8; ++i)
+                list.append (list.create (i));
+            expectEquals (list.getNumFree(), 0);
+            expectEquals (Item::numLive, 8);
+            expectEquals (list.at(5)->value, 5);
+
+            list.removeAll();
+            expectEquals (list.count(), 0);
+            expectEquals (list.getNumFree(), 8);
+
+            for (int i = 0; i < 8; ++i)
+                list.append (list.create (i * 10));
+            expectEquals (Item::numLive, 8);
+            expectEquals (list.last()->value, 70);
+
+            list.clear();
+            expectEquals (Item::numLive, 0);
+        }
+
+        beginTest ("index cache");
+        {
+            LinkedList<Item> list;
+            list.setScoped (true);
+            list.setIndexCached (true);
+            Array<Item*> items;
+            for (int i = 0; i < 100; ++i)
+            {
+                items.add (list.create (i));
+                list.append (items.getLast());
+            }
+
+            bool ok = true;
+            for (int i = 0; i < 100; ++i)
+                ok = ok && list.at (i) == items[i] && list.find (items[i]) == i;
+            for (int i = 99; i >= 0; i -= 7)
+                ok = ok && list.find (items[i]) == i && list.at (i) == items[i];
+            expect (ok);
+
+            // edits invalidate the cached position
+            list.at (50);
+            list.remove (items[10]);
+            expect (list.at (50) == items[51]);
+            expectEquals (list.find (items[51]), 50);
+            expectEquals (list.find (items[10]), -1);
+            expectEquals (list.find (items[9]), 9);
+            list.insertAfter (list.create (-1), items[9]);
+            expectEquals (list.find (items[51]), 51);
+            expectEquals (list.at (10)->value, -1);
+        }
+    }
+};
+
+int LinkedListTests::Item::numLive = 0;
+
+static LinkedListTests sLinkedListTests;
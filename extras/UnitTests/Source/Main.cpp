@@ -57,6 +57,22 @@ public:
 
 static DummyTest sDummyTest;
 
+#include "ArcListTests.cpp"
+#include "AudioRingBufferTests.cpp"
+#include "ArcTableTests.cpp"
+#include "AtomicTests.cpp"
+#include "ChannelMapTests.cpp"
+#include "GraphCompilerTests.cpp"
+#include "LinkedListTests.cpp"
+#include "MatrixStateTests.cpp"
+#include "MonitorTests.cpp"
+#include "ParameterTests.cpp"
+#include "PortTypeTests.cpp"
+#include "RingBufferTests.cpp"
+#include "SemaphoreTests.cpp"
+#include "TimeScaleTests.cpp"
+#include "WorkThreadTests.cpp"
+
 }
 
 int main (int argc, char* argv[])
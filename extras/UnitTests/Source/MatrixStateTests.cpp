@@ -0,0 +1,207 @@
+/*
+    This file is part of the Kushview Modules for JUCE
+    Copyright (c) 2014-2019  Kushview, LLC.  All rights reserved.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+class MatrixStateTests : public UnitTest
+{
+public:
+    MatrixStateTests() : UnitTest ("MatrixState") { }
+
+    static void randomize (MatrixState& matrix, Random& random, int percentOn)
+    {
+        for (int r = 0; r < matrix.getNumRows(); ++r)
+            for (int c = 0; c < matrix.getNumColumns(); ++c)
+                matrix.set (r, c, random.nextInt (100) < percentOn);
+    }
+
+    void runTest() override
+    {
+        Random random (321);
+
+        beginTest ("cells");
+        {
+            MatrixState matrix (3, 70);
+            matrix.connect (1, 69);
+            matrix.toggleCell (2, 3);
+            expect (matrix.connected (1, 69));
+            expect (matrix.connectedAtIndex (matrix.getIndexForCell (2, 3)));
+            expect (! matrix.connected (1, 70));
+            expect (! matrix.connected (3, 0));
+            matrix.connect (0, 70);
+            expectEquals (matrix.getNumConnected(), 2);
+        }
+
+        beginTest ("rows and columns");
+        {
+            MatrixState matrix (5, 130);
+            matrix.setRow (1, true);
+            expectEquals (matrix.getNumConnected(), 130);
+            matrix.copyRow (1, 3);
+            expectEquals (matrix.getNumConnected(), 260);
+            expect (matrix.isRowEmpty (0) && ! matrix.isRowEmpty (3));
+
+            matrix.clearColumn (129);
+            expect (! matrix.connected (1, 129) && ! matrix.connected (3, 129));
+            matrix.copyColumn (129, 64);
+            expect (! matrix.connected (1, 64));
+            matrix.setColumn (7, true);
+            expect (matrix.connected (0, 7) && matrix.connected (4, 7));
+            matrix.copyColumn (7, 128);
+            expect (matrix.connected (2, 128));
+            matrix.clearRow (1);
+            expect (matrix.isRowEmpty (1));
+            matrix.clear();
+            expectEquals (matrix.getNumConnected(), 0);
+        }
+
+        beginTest ("resize and retain");
+        {
+            MatrixState matrix (10, 100);
+            randomize (matrix, random, 30);
+            const MatrixState old (matrix);
+            matrix.resize (6, 66, true);
+
+            bool same = true;
+            for (int r = 0; r < 6; ++r)
+                for (int c = 0; c < 66; ++c)
+                    same = same && matrix.connected (r, c) == old.connected (r, c);
+            expect (same);
+
+            matrix.resize (12, 200, true);
+            int count = 0;
+            for (int r = 0; r < 6; ++r)
+                for (int c = 0; c < 66; ++c)
+                    count += old.connected (r, c) ? 1 : 0;
+            expectEquals (matrix.getNumConnected(), count);
+        }
+
+        beginTest ("encoding");
+        {
+            for (const int percentOn : { 0, 1, 50, 99, 100 })
+            {
+                MatrixState matrix (17, 93);
+                randomize (matrix, random, percentOn);
+
+                for (const bool runLength : { true, false })
+                {
+                    const MemoryBlock block (matrix.encodeCells (runLength));
+                    MatrixState restored (17, 93);
+                    expect (restored.decodeCells (block.getData(), block.getSize(), runLength));
+                    expect (restored == matrix);
+                }
+            }
+
+            MatrixState diagonal (512, 512);
+            for (int i = 0; i < 512; ++i)
+                diagonal.connect (i, i);
+            expect (diagonal.encodeCells (true).getSize() < 2048);
+            expectEquals ((int) diagonal.encodeCells (false).getSize(), 512 * 512 / 8);
+
+           #if JUCE_MODULE_AVAILABLE_juce_data_structures
+            MatrixState restored;
+            restored.restoreFromValueTree (diagonal.createValueTree());
+            expect (restored == diagonal);
+           #endif
+        }
+
+        beginTest ("find next connected");
+        {
+            MatrixState matrix (2, 200);
+            for (const int c : { 0, 63, 64, 130, 199 })
+                matrix.connect (1, c);
+
+            Array<int> found;
+            for (int c = matrix.findNextConnected (1, 0); c >= 0; c = matrix.findNextConnected (1, c + 1))
+                found.add (c);
+            expect (found == Array<int> ({ 0, 63, 64, 130, 199 }));
+            expectEquals (matrix.findNextConnected (0, 0), -1);
+        }
+
+        testRealtimeSnapshots();
+    }
+
+    /** Publishes matrices whose connections depend on the version, while a
+        reader thread checks every snapshot it sees is whole */
+    struct Reader : public Thread
+    {
+        Reader (RealtimeMatrixState& m) : Thread ("reader"), matrix (m) { }
+
+        void run() override
+        {
+            while (! threadShouldExit())
+            {
+                const RealtimeMatrixState::Snapshot& snapshot = matrix.acquire();
+                const uint32 version = snapshot.getVersion();
+                if (version == 0)
+                    continue;
+
+                const int shift = (int) (version % 16);
+                const MatrixState& state = snapshot.getState();
+                bool ok = snapshot.getNumConnections() == state.getNumRows()
+                       && state.getNumConnected() == state.getNumRows();
+                for (int row = 0; ok && row < state.getNumRows(); ++row)
+                {
+                    const Range<int> range (snapshot.getRowRange (row));
+                    ok = range.getLength() == 1
+                      && snapshot.getConnection (range.getStart()).row == row
+                      && snapshot.getConnection (range.getStart()).column == (row + shift) % state.getNumColumns();
+                }
+
+                if (! ok)
+                    ++errors;
+                if (version < lastVersion)
+                    ++errors;
+                lastVersion = version;
+                ++reads;
+            }
+        }
+
+        RealtimeMatrixState& matrix;
+        uint32 lastVersion = 0;
+        int errors = 0;
+        std::atomic<int> reads { 0 };
+    };
+
+    void testRealtimeSnapshots()
+    {
+        beginTest ("realtime snapshots");
+        RealtimeMatrixState realtime;
+        expectEquals ((int) realtime.acquire().getVersion(), 0);
+
+        Reader reader (realtime);
+        reader.startThread();
+
+        for (uint32 version = 1; version <= 2000; ++version)
+        {
+            MatrixState matrix (8, 16);
+            for (int row = 0; row < 8; ++row)
+                matrix.connect (row, (row + (int) (version % 16)) % 16);
+            realtime.publish (matrix);
+        }
+
+        while (reader.reads.load() < 100)
+            Thread::yield();
+        reader.stopThread (1000);
+
+        expectEquals (reader.errors, 0);
+        expectEquals ((int) realtime.acquire().getVersion(), 2000);
+        expect (! realtime.hasNewSnapshot());
+    }
+};
+
+static MatrixStateTests sMatrixStateTests;
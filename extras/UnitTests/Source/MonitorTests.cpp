@@ -0,0 +1,122 @@
+/*
+    This file is part of the Kushview Modules for JUCE
+    Copyright (c) 2014-2019  Kushview, LLC.  All rights reserved.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+class MonitorTests : public UnitTest
+{
+public:
+    MonitorTests() : UnitTest ("Monitor") { }
+
+    enum { numChannels = 64, blockSize = 32 };
+
+    /** Publishes cycles where every channel carries the cycle number, while
+        readers check every snapshot comes from a single cycle */
+    struct Reader : public Thread
+    {
+        Reader (MonitorBank& b) : Thread ("reader"), bank (b) { }
+
+        void run() override
+        {
+            MonitorBank::Snapshot snapshot;
+            while (! threadShouldExit())
+            {
+                if (! bank.read (snapshot) || snapshot.cycle == 0)
+                    continue;
+
+                const float expected = (float) (snapshot.cycle % 1000) / 1000.0f;
+                for (int i = 0; i < numChannels; ++i)
+                    if (snapshot.peaks[i] != expected || std::abs (snapshot.rms[i] - expected) > 1.0e-5f)
+                        ++errors;
+                ++reads;
+            }
+        }
+
+        MonitorBank& bank;
+        int errors = 0;
+        std::atomic<int> reads { 0 };
+    };
+
+    void runTest() override
+    {
+        beginTest ("monitor path");
+        {
+            Monitor monitor (Array<int> ({ 3, 7 }), 1);
+            expectEquals (monitor.procNode(), 7);
+        }
+
+        beginTest ("peak hold and rms");
+        {
+            MonitorBank bank (2, 2, 0.5f);
+            const float loud[] = { 0.5f, -1.0f, 0.5f, -0.5f };
+            const float quiet[] = { 0.25f, -0.25f };
+
+            bank.addSamples (0, loud, 4);
+            bank.addSamples (1, quiet, 2);
+            bank.publish();
+
+            MonitorBank::Snapshot snapshot;
+            expect (bank.read (snapshot));
+            expectEquals ((int) snapshot.cycle, 1);
+            expectEquals (snapshot.peaks[0], 1.0f);
+            expectWithinAbsoluteError (snapshot.rms[0], std::sqrt (1.75f / 4.0f), 1.0e-6f);
+            expectEquals (snapshot.peaks[1], 0.25f);
+            expectWithinAbsoluteError (snapshot.rms[1], 0.25f, 1.0e-6f);
+
+            // held for two silent cycles, then falls by half each cycle
+            float expected[] = { 1.0f, 1.0f, 0.5f, 0.25f };
+            for (const float peak : expected)
+            {
+                bank.publish();
+                expect (bank.read (snapshot));
+                expectEquals (snapshot.peaks[0], peak);
+                expectEquals (snapshot.rms[0], 0.0f);
+            }
+        }
+
+        beginTest ("consistent snapshots");
+        {
+            MonitorBank bank (numChannels);
+            OwnedArray<Reader> readers;
+            for (int i = 0; i < 2; ++i)
+                readers.add (new Reader (bank));
+            for (auto* r : readers)
+                r->startThread();
+
+            HeapBlock<float> samples (blockSize);
+            for (uint32 cycle = 1; cycle <= 5000; ++cycle)
+            {
+                FloatVectorOperations::fill (samples, (float) (cycle % 1000) / 1000.0f, blockSize);
+                for (int i = 0; i < numChannels; ++i)
+                    bank.addSamples (i, samples, blockSize);
+                bank.publish();
+            }
+
+            for (auto* r : readers)
+            {
+                while (r->reads.load() < 10)
+                    Thread::yield();
+                r->stopThread (1000);
+                expectEquals (r->errors, 0);
+            }
+
+            expectEquals ((int) bank.getCycle(), 5000);
+        }
+    }
+};
+
+static MonitorTests sMonitorTests;
@@ -0,0 +1,163 @@
+/*
+    This file is part of the Kushview Modules for JUCE
+    Copyright (c) 2014-2019  Kushview, LLC.  All rights reserved.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+class ParameterTests : public UnitTest
+{
+public:
+    ParameterTests() : UnitTest ("Parameter") { }
+
+    void runTest() override
+    {
+        beginTest ("log mapping");
+        {
+            const Parameter::LogMapping mapping (20.0, 20000.0, 5.0);
+            for (double v = 20.0; v <= 20000.0; v += 997.0)
+            {
+                expectWithinAbsoluteError (mapping.mapLog (v), Parameter::mapLog (v, 20.0, 20000.0, 5.0), 1.0e-12);
+                expectWithinAbsoluteError (mapping.mapExp (mapping.mapLog (v)), v, 1.0e-6);
+            }
+
+            Parameter param;
+            param.setMinMaxValue (20.0, 20000.0, 632.0);
+            expectWithinAbsoluteError (param.getValueLogarithmic(),
+                20.0 * std::pow (1000.0, param.getNormalValue()), 1.0e-6);
+        }
+
+        beginTest ("linear ramp");
+        {
+            SmoothedParameter param (0.0f);
+            param.prepare (1000.0, 0.1);
+            param.setTargetValue (1.0f);
+            expect (param.isSmoothing());
+
+            float buffer [64];
+            param.fill (buffer, 64);
+            for (int i = 0; i < 64; ++i)
+                expectWithinAbsoluteError (buffer[i], (float) (i + 1) / 100.0f, 1.0e-5f);
+
+            param.fill (buffer, 64);
+            expectWithinAbsoluteError (buffer[0], 0.65f, 1.0e-5f);
+            expectEquals (buffer[35], 1.0f);
+            expectEquals (buffer[63], 1.0f);
+            expect (! param.isSmoothing());
+        }
+
+        beginTest ("multiplicative ramp");
+        {
+            SmoothedParameter param (100.0f, SmoothedParameter::Multiplicative);
+            param.prepare (1000.0, 0.1);
+            param.setTargetValue (10000.0f);
+
+            float buffer [37];
+            int count = 0;
+            while (count < 100)
+            {
+                const int n = jmin (37, 100 - count);
+                param.fill (buffer, n);
+                for (int i = 0; i < n; ++i)
+                {
+                    const double expected = 100.0 * std::pow (100.0, (double) (count + i + 1) / 100.0);
+                    expectWithinAbsoluteError ((double) buffer[i], expected, expected * 1.0e-4);
+                }
+                count += n;
+            }
+
+            expectEquals (buffer[(100 % 37) - 1], 10000.0f);
+            expect (! param.isSmoothing());
+        }
+
+        beginTest ("multiplicative falls back through zero");
+        {
+            SmoothedParameter param (-1.0f, SmoothedParameter::Multiplicative);
+            param.prepare (1000.0, 0.004);
+            param.setTargetValue (1.0f);
+            float buffer [4];
+            param.fill (buffer, 4);
+            expectEquals (buffer[0], -0.5f);
+            expectEquals (buffer[1], 0.0f);
+            expectEquals (buffer[3], 1.0f);
+        }
+
+        beginTest ("retarget mid ramp");
+        {
+            SmoothedParameter param (0.0f);
+            param.prepare (1000.0, 0.01);
+            param.setTargetValue (1.0f);
+            float buffer [5];
+            param.fill (buffer, 5);
+            expectWithinAbsoluteError (param.getCurrentValue(), 0.5f, 1.0e-6f);
+
+            param.setTargetValue (0.0f);
+            param.fill (buffer, 5);
+            expectWithinAbsoluteError (buffer[4], 0.25f, 1.0e-6f);
+        }
+
+        beginTest ("apply gain");
+        {
+            SmoothedParameter gain (1.0f);
+            gain.prepare (1000.0, 0.2);
+            gain.setTargetValue (0.0f);
+
+            HeapBlock<float> samples (300);
+            for (int i = 0; i < 300; ++i)
+                samples[i] = 2.0f;
+
+            gain.applyGain (samples, 300);
+            expectWithinAbsoluteError (samples[99], 1.0f, 1.0e-5f);
+            expectEquals (samples[199], 0.0f);
+            expectEquals (samples[299], 0.0f);
+        }
+
+        beginTest ("targets from another thread");
+        {
+            SmoothedParameter param (0.0f);
+            param.prepare (1000.0, 0.01);
+
+            struct Writer : public Thread
+            {
+                Writer (SmoothedParameter& p) : Thread ("writer"), param (p) { }
+                void run() override
+                {
+                    for (int i = 1; i <= 1000; ++i)
+                        param.setTargetValue ((float) (i % 2));
+                }
+                SmoothedParameter& param;
+            } writer (param);
+
+            writer.startThread();
+            float buffer [16];
+            int errors = 0;
+            while (writer.isThreadRunning())
+            {
+                param.fill (buffer, 16);
+                for (const auto v : buffer)
+                    if (v < 0.0f || v > 1.0f)
+                        ++errors;
+            }
+
+            writer.stopThread (1000);
+            param.fill (buffer, 16);
+            param.fill (buffer, 16);
+            expectEquals (errors, 0);
+            expectEquals (buffer[15], 0.0f);
+        }
+    }
+};
+
+static ParameterTests sParameterTests;
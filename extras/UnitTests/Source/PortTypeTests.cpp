@@ -0,0 +1,57 @@
+/*
+    This file is part of the Kushview Modules for JUCE
+    Copyright (c) 2014-2019  Kushview, LLC.  All rights reserved.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+static_assert (PortType::getSlugLiteral (PortType::Audio)[0] == 'a', "port type tables should be constexpr");
+
+class PortTypeTests : public UnitTest
+{
+public:
+    PortTypeTests() : UnitTest ("PortType") { }
+
+    void runTest() override
+    {
+        beginTest ("resolve from strings");
+        for (int i = PortType::Control; i <= PortType::Midi; ++i)
+        {
+            const PortType type (i);
+            expect (PortType (type.getURI()) == type);
+            expect (PortType (type.getName()) == type);
+            expect (PortType (type.getSlug()) == type);
+            expect (PortType (String (PortType::getSlugLiteral (i))) == type);
+            expectEquals (type.getURI(), String (PortType::getURILiteral (i)));
+        }
+
+        expect (PortType (String ("AUDIO")) == PortType::Unknown);
+        expect (PortType (String ("")) == PortType::Unknown);
+        expect (PortType (String ("http://lv2plug.in/ns/lv2core#Port")) == PortType::Unknown);
+
+        beginTest ("resolve from identifiers");
+        for (int i = PortType::Control; i <= PortType::Midi; ++i)
+        {
+            const PortType type (i);
+            expect (PortType (Identifier (type.getSlug())) == type);
+            expect (PortType (Identifier (type.getURI())) == type);
+            expect (PortType (Identifier (type.getName())) == type);
+        }
+
+        expect (PortType (Identifier ("audioport")) == PortType::Unknown);
+    }
+};
+
+static PortTypeTests sPortTypeTests;
@@ -0,0 +1,120 @@
+/*
+    This file is part of the Kushview Modules for JUCE
+    Copyright (c) 2014-2019  Kushview, LLC.  All rights reserved.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+
+class RingBufferTests : public UnitTest
+{
+public:
+    RingBufferTests() : UnitTest ("RingBuffer") { }
+
+    /** Copies from the two vectors in order */
+    static void gather (const RingBuffer::Vector* vec, uint8* dest)
+    {
+        memcpy (dest, vec[0].buffer, vec[0].size);
+        memcpy (dest + vec[0].size, vec[1].buffer, vec[1].size);
+    }
+
+    void runTest() override
+    {
+        beginTest ("contiguous vectors");
+        {
+            RingBuffer ring (16);
+            RingBuffer::Vector vec[2];
+            expectEquals ((int) ring.getWriteVector (vec), 15);
+            expectEquals ((int) vec[0].size, 15);
+            expectEquals ((int) vec[1].size, 0);
+
+            expectEquals ((int) ring.getReadVector (vec), 0);
+            expectEquals ((int) (vec[0].size + vec[1].size), 0);
+        }
+
+        beginTest ("vectors split across the end");
+        {
+            RingBuffer ring (16);
+            uint8 scratch[16] = {};
+            ring.write (scratch, 10);
+            ring.read (scratch, 10);
+
+            // 6 bytes up to the end of the block, then 9 from the start
+            RingBuffer::Vector vec[2];
+            expectEquals ((int) ring.getWriteVector (vec), 15);
+            expectEquals ((int) vec[0].size, 6);
+            expectEquals ((int) vec[1].size, 9);
+
+            // fill only part of the space, across the wrap
+            uint8 data[10];
+            for (int i = 0; i < 10; ++i)
+                data[i] = (uint8) (100 + i);
+            memcpy (vec[0].buffer, data, vec[0].size);
+            memcpy (vec[1].buffer, data + vec[0].size, 10 - vec[0].size);
+            ring.commitWrite (10);
+            expectEquals ((int) ring.getReadSpace(), 10);
+            expectEquals ((int) ring.getWriteSpace(), 5);
+
+            expectEquals ((int) ring.getReadVector (vec), 10);
+            expectEquals ((int) vec[0].size, 6);
+            expectEquals ((int) vec[1].size, 4);
+            uint8 out[16] = {};
+            gather (vec, out);
+            expect (memcmp (out, data, 10) == 0);
+
+            // a partial read leaves the rest, still split
+            ring.commitRead (3);
+            expectEquals ((int) ring.getReadVector (vec), 7);
+            expectEquals ((int) vec[0].size, 3);
+            expectEquals ((int) vec[1].size, 4);
+            gather (vec, out);
+            expect (memcmp (out, data + 3, 7) == 0);
+
+            // past the wrap the data is contiguous again
+            ring.commitRead (5);
+            expectEquals ((int) ring.getReadVector (vec), 2);
+            expectEquals ((int) vec[0].size, 2);
+            expectEquals ((int) vec[1].size, 0);
+            expectEquals ((int) *static_cast<const uint8*> (vec[0].buffer), 108);
+
+            ring.commitRead (2);
+            expectEquals ((int) ring.getReadSpace(), 0);
+            expectEquals ((int) ring.getWriteSpace(), 15);
+        }
+
+        beginTest ("vectors and copies agree");
+        {
+            RingBuffer ring (16);
+            uint8 scratch[16] = {};
+            ring.write (scratch, 12);
+            ring.read (scratch, 12);
+
+            RingBuffer::Vector vec[2];
+            ring.getWriteVector (vec);
+            uint8 data[8];
+            for (int i = 0; i < 8; ++i)
+                data[i] = (uint8) i;
+            memcpy (vec[0].buffer, data, vec[0].size);
+            memcpy (vec[1].buffer, data + vec[0].size, 8 - vec[0].size);
+            ring.commitWrite (8);
+
+            uint8 out[8] = {};
+            expectEquals ((int) ring.read (out, 8), 8);
+            expect (memcmp (out, data, 8) == 0);
+        }
+    }
+};
+
+static RingBufferTests sRingBufferTests;
@@ -0,0 +1,94 @@
+/*
+    This file is part of the Kushview Modules for JUCE
+    Copyright (c) 2014-2019  Kushview, LLC.  All rights reserved.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+class SemaphoreTests : public UnitTest
+{
+public:
+    SemaphoreTests() : UnitTest ("Semaphore") { }
+
+    struct Waiter : public Thread
+    {
+        Waiter (Semaphore& s) : Thread ("waiter"), sem (s) { }
+
+        void run() override
+        {
+            while (! threadShouldExit())
+                if (sem.timedWait (10))
+                    ++wakes;
+        }
+
+        Semaphore& sem;
+        std::atomic<int> wakes { 0 };
+    };
+
+    void runTest() override
+    {
+        beginTest ("count");
+        {
+            Semaphore sem (2);
+            expect (sem.tryWait());
+            expect (sem.tryWait());
+            expect (! sem.tryWait());
+            sem.post (3);
+            expect (sem.timedWait (0));
+            expect (sem.timedWait (-1));
+            expect (sem.timedWait (10));
+            expect (! sem.tryWait());
+        }
+
+        beginTest ("timed wait expires");
+        {
+            Semaphore sem;
+            const uint32 start = Time::getMillisecondCounter();
+            expect (! sem.timedWait (50));
+            expect (Time::getMillisecondCounter() - start >= 40);
+        }
+
+        beginTest ("batch post wakes many threads");
+        {
+            Semaphore sem;
+            OwnedArray<Waiter> waiters;
+            for (int i = 0; i < 4; ++i)
+                waiters.add (new Waiter (sem));
+            for (auto* w : waiters)
+                w->startThread();
+
+            for (int round = 0; round < 100; ++round)
+                sem.post (4);
+
+            const uint32 start = Time::getMillisecondCounter();
+            int total = 0;
+            while (total < 400 && Time::getMillisecondCounter() - start < 5000)
+            {
+                Thread::sleep (2);
+                total = 0;
+                for (auto* w : waiters)
+                    total += w->wakes.load();
+            }
+
+            for (auto* w : waiters)
+                w->stopThread (1000);
+
+            expectEquals (total, 400);
+            expect (! sem.tryWait());
+        }
+    }
+};
+
+static SemaphoreTests sSemaphoreTests;
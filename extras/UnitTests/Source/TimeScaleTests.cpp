@@ -0,0 +1,541 @@
+/*
+    This file is part of the Kushview Modules for JUCE
+    Copyright (c) 2014-2019  Kushview, LLC.  All rights reserved.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+class TimeScaleTests : public UnitTest
+{
+public:
+    TimeScaleTests() : UnitTest ("TimeScale") { }
+
+    /** The node a linear walk of the list finds for a key */
+    template<typename KeyType>
+    static const TimeScale::Node* walk (const TimeScale& ts, KeyType TimeScale::Node::* key, KeyType value)
+    {
+        const TimeScale::Node* found = ts.nodes().first();
+        for (const TimeScale::Node* node = found; node != nullptr; node = node->next())
+            if (node->*key <= value)
+                found = node;
+        return found;
+    }
+
+    void checkSeeks (TimeScale& ts, Random& rng, int numSeeks)
+    {
+        const TimeScale::Node* const last = ts.nodes().last();
+        int errors = 0;
+        for (int i = 0; i < numSeeks; ++i)
+        {
+            const uint64 frame = (uint64) rng.nextInt64() % (last->frame + 100000);
+            const uint64 tick  = (uint64) rng.nextInt64() % (last->tick + 10000);
+            const unsigned int beat = (unsigned int) rng.nextInt ((int) last->beat + 16);
+            const unsigned short bar = (unsigned short) rng.nextInt ((int) last->bar + 4);
+            const int pixel = rng.nextInt (last->pixel + 1000);
+
+            auto& cursor = ts.cursor();
+            if (cursor.seekFrame (frame) != walk (ts, &TimeScale::Node::frame, frame)) ++errors;
+            if (cursor.seekTick (tick)   != walk (ts, &TimeScale::Node::tick, tick))   ++errors;
+            if (cursor.seekBeat (beat)   != walk (ts, &TimeScale::Node::beat, beat))   ++errors;
+            if (cursor.seekBar (bar)     != walk (ts, &TimeScale::Node::bar, bar))     ++errors;
+            if (cursor.seekPixel (pixel) != walk (ts, &TimeScale::Node::pixel, pixel)) ++errors;
+        }
+
+        expectEquals (errors, 0);
+    }
+
+    void runTest() override
+    {
+        Random rng (1234);
+        TimeScale ts;
+        ts.setSampleRate (48000);
+        ts.updateScale();
+
+        beginTest ("seek matches a list walk");
+        for (int i = 1; i <= 1000; ++i)
+            ts.addNode ((uint64) i * 48000 * 4, 60.0f + (float) (i % 120));
+        expect (ts.nodes().count() > 900);
+        checkSeeks (ts, rng, 2000);
+
+        beginTest ("seek after edits");
+        for (int round = 0; round < 50; ++round)
+        {
+            // remove one, move one, insert one, each followed by seeks
+            TimeScale::Node* node = ts.nodes().at (1 + rng.nextInt (ts.nodes().count() - 1));
+            ts.removeNode (node);
+            checkSeeks (ts, rng, 20);
+
+            node = ts.nodes().at (1 + rng.nextInt (ts.nodes().count() - 1));
+            node->tempo = 90.0f + (float) rng.nextInt (60);
+            ts.updateNode (node);
+            checkSeeks (ts, rng, 20);
+
+            ts.addNode ((uint64) rng.nextInt (1000) * 48000 * 3, 70.0f + (float) rng.nextInt (60));
+            checkSeeks (ts, rng, 20);
+        }
+
+        beginTest ("seek after rescaling");
+        ts.setPixelsPerBeat (48);
+        ts.updateScale();
+        checkSeeks (ts, rng, 500);
+
+        TimeScale copy (ts);
+        expectEquals (copy.nodes().count(), ts.nodes().count());
+        checkSeeks (copy, rng, 500);
+
+        ts.reset();
+        expect (ts.cursor().seekFrame (123456) == ts.nodes().first());
+
+        testSnapshot (rng);
+        testRealtime();
+        testBatch (rng);
+        testExact (rng);
+        testGridLines();
+    }
+
+    void testGridLines()
+    {
+        beginTest ("grid lines match beat conversions");
+        TimeScale ts;
+        ts.setSampleRate (48000);
+        ts.setSnapPerBeat (4);
+        ts.updateScale();
+        ts.addNode ((uint64) 48000 * 30, 97.0f, 2, 3);
+        ts.addNode ((uint64) 48000 * 90, 160.0f, 2, 7);
+
+        const int endPixel = ts.pixelFromFrame ((uint64) 48000 * 120);
+        const Array<TimeScale::GridLine>& lines (ts.getGridLines (0, endPixel));
+
+        int beats = 0;
+        for (int i = 0; i < lines.size(); ++i)
+        {
+            const TimeScale::GridLine& line (lines.getReference (i));
+            if (i > 0)
+                expect (line.pixel >= lines.getReference (i - 1).pixel);
+            if (! line.isBeat)
+                continue;
+
+            expectEquals (line.pixel, ts.pixelFromBeat (line.beat));
+            expect (line.isBar == ts.beatIsBar (line.beat));
+            ++beats;
+        }
+
+        expect (beats > 0);
+        expectEquals ((int) lines.getLast().beat, (int) ts.beatFromPixel (lines.getLast().pixel));
+
+        beginTest ("grid lines are cached until the map changes");
+        const TimeScale::GridLine* data = lines.begin();
+        const int numLines = lines.size();
+        ts.getGridLines (100, endPixel / 2);
+        expect (lines.begin() == data && lines.size() == numLines);
+
+        ts.addNode ((uint64) 48000 * 60, 200.0f);
+        const Array<TimeScale::GridLine>& edited (ts.getGridLines (0, endPixel));
+        expect (edited.size() != numLines);
+
+        ts.setSnapPerBeat (1);
+        const Array<TimeScale::GridLine>& beatsOnly (ts.getGridLines (0, endPixel));
+        for (int i = 0; i < beatsOnly.size(); ++i)
+            expect (beatsOnly.getReference (i).isBeat);
+
+        beginTest ("grid lines thin out when zoomed out");
+        ts.setSnapPerBeat (16);
+        for (int zoom = 1; zoom <= 19683; zoom *= 3)
+        {
+            ts.setHorizontalZoom ((unsigned short) zoom);
+            ts.setPixelsPerBeat (2);
+            ts.updateScale();
+
+            const int width = ts.pixelFromFrame ((uint64) 48000 * 60 * 10);
+            const Array<TimeScale::GridLine>& thinned (ts.getGridLines (0, width, 6));
+            expect (thinned.size() > 0);
+
+            int tooClose = 0, snaps = 0, beatsOnBars = 0;
+            for (int i = 1; i < thinned.size(); ++i)
+            {
+                // a tempo change can leave one short gap at the node
+                if (thinned.getReference (i).pixel - thinned.getReference (i - 1).pixel < 5)
+                    ++tooClose;
+                if (! thinned.getReference (i).isBeat)
+                    ++snaps;
+                if (thinned.getReference (i).isBeat && ! thinned.getReference (i).isBar)
+                    ++beatsOnBars;
+            }
+
+            expect (tooClose <= 3);
+
+            // the map's tempos run from 97 to 200 bpm
+            const float pixelRate = 1.2f * (float) (zoom * 2);
+            if (pixelRate / 97.0f < 6.0f)
+                expectEquals (beatsOnBars + snaps, 0);
+            if (pixelRate / (200.0f * 16.0f) >= 7.0f)
+                expect (snaps > 0);
+        }
+    }
+
+    /** A random tempo map over a day. Below 180 bpm with at least 4 beats
+        a bar a day is under 64500 bars, so bar numbers fit an unsigned short */
+    void fillRandomTempoMap (TimeScale& ts, Random& rng, uint64 span)
+    {
+        for (int i = 0; i < 50; ++i)
+            ts.addNode ((uint64) rng.nextInt64() % span, 100.0f + 79.0f * rng.nextFloat(),
+                        2, (unsigned short) (4 + rng.nextInt (5)));
+
+        // a wrapped bar would leave the bar index unsorted. Nodes snap to
+        // bars, so the last one can land past the span
+        bool barsIncrease = true;
+        for (const TimeScale::Node* node = ts.nodes().first(); node->next() != nullptr; node = node->next())
+            barsIncrease &= node->next()->bar >= node->bar;
+        const TimeScale::Node* const last = ts.nodes().last();
+        expect (barsIncrease && ts.barFromFrame (jmax (span, last->frame)) >= last->bar,
+                "bar numbers wrapped");
+    }
+
+    void testExact (Random& rng)
+    {
+        beginTest ("exact mode frame -> tick -> frame");
+        const unsigned int rates[] = { 44100, 48000, 96000 };
+        for (int trial = 0; trial < 12; ++trial)
+        {
+            // a tick must be no longer than a frame for frames to survive
+            TimeScale ts;
+            ts.setExactMode (true);
+            ts.setSampleRate (rates [trial % 3]);
+            ts.setTicksPerBeat (60000);
+            ts.updateScale();
+
+            const uint64 span = (uint64) 24 * 60 * 60 * ts.getSampleRate();
+            fillRandomTempoMap (ts, rng, span);
+
+            int errors = 0;
+            for (int i = 0; i < 2000; ++i)
+            {
+                const uint64 frame = (uint64) rng.nextInt64() % span;
+                if (ts.frameFromTick (ts.tickFromFrame (frame)) != frame)
+                    ++errors;
+            }
+            expectEquals (errors, 0);
+        }
+
+        beginTest ("exact mode tick -> frame -> tick");
+        for (int trial = 0; trial < 12; ++trial)
+        {
+            TimeScale ts;
+            ts.setExactMode (true);
+            ts.setSampleRate (rates [trial % 3]);
+            ts.updateScale();
+
+            const uint64 span = (uint64) 24 * 60 * 60 * ts.getSampleRate();
+            fillRandomTempoMap (ts, rng, span);
+
+            const uint64 maxTick = ts.tickFromFrame (span);
+            const TimeScaleSnapshot::Ptr snapshot (new TimeScaleSnapshot (ts));
+            TimeScaleSnapshot::Cursor cursor;
+
+            int errors = 0;
+            for (int i = 0; i < 2000; ++i)
+            {
+                const uint64 tick = (uint64) rng.nextInt64() % maxTick;
+                const uint64 frame = ts.frameFromTick (tick);
+                if (ts.tickFromFrame (frame) != tick)
+                    ++errors;
+                if (snapshot->frameFromTick (tick, cursor) != frame)
+                    ++errors;
+
+                uint64 batch = 0;
+                ts.framesFromTicks (&tick, &batch, 1, TimeScale::RationalPrecision);
+                if (batch != frame)
+                    ++errors;
+            }
+            expectEquals (errors, 0);
+        }
+
+        beginTest ("exact mode doesn't drift");
+        {
+            TimeScale ts;
+            ts.setExactMode (true);
+            ts.setSampleRate (96000);
+            ts.setTempo (133.7f);
+            ts.updateScale();
+
+            // ten hours in, the frame is the tick scaled by the exact tempo
+            uint64 num, den;
+            ts.nodes().first()->getTickFrameRatio (num, den);
+            const uint64 tick = (uint64) TimeScale::scaleExact ((int64) 10 * 60 * 60 * 96000, num, den);
+            expectEquals (ts.frameFromTick (tick), (uint64) TimeScale::scaleExact ((int64) tick, den, num));
+            expectEquals (ts.tickFromFrame (ts.frameFromTick (tick)), tick);
+        }
+    }
+
+    void testBatch (Random& rng)
+    {
+        beginTest ("batch conversion");
+        TimeScale ts;
+        ts.setSampleRate (96000);
+        ts.updateScale();
+        for (int i = 1; i <= 20; ++i)
+            ts.addNode ((uint64) i * 96000 * 60, 90.0f + 0.37f * (float) i);
+
+        // sorted frames over 24 hours, crossing every segment
+        const int numValues = 10000;
+        const uint64 span = (uint64) 24 * 60 * 60 * 96000;
+        HeapBlock<uint64> frames (numValues), ticks (numValues), exact (numValues), back (numValues);
+        for (int i = 0; i < numValues; ++i)
+            frames[i] = (span / numValues) * (uint64) i + (uint64) rng.nextInt (1000);
+
+        ts.ticksFromFrames (frames, ticks, numValues);
+        ts.ticksFromFrames (frames, exact, numValues, TimeScale::RationalPrecision);
+
+        int errors = 0;
+        for (int i = 0; i < numValues; ++i)
+        {
+            const TimeScale::Node* const node = ts.cursor().seekFrame (frames[i]);
+            if (frames[i] - node->frame < 96000 && std::abs ((int64) (ticks[i] - ts.tickFromFrame (frames[i]))) > 1)
+                ++errors;   // near the node float and double agree
+            if (std::abs ((int64) (ticks[i] - exact[i])) > 1)
+                ++errors;   // double stays within a tick over 24 hours
+        }
+        expectEquals (errors, 0);
+
+        beginTest ("rational round trip");
+        // a tick is longer than a frame, so tick -> frame -> tick is lossless
+        for (int i = 0; i < numValues; ++i)
+            ticks[i] = exact[i] + (uint64) rng.nextInt (100);
+        ts.framesFromTicks (ticks, back, numValues, TimeScale::RationalPrecision);
+        ts.ticksFromFrames (back, exact, numValues, TimeScale::RationalPrecision);
+
+        errors = 0;
+        for (int i = 0; i < numValues; ++i)
+            if (exact[i] != ticks[i])
+                ++errors;
+        expectEquals (errors, 0);
+
+        // unsorted input still lands in the right segments
+        for (int i = 0; i < numValues; ++i)
+            frames[i] = (uint64) rng.nextInt64() % span;
+        ts.ticksFromFrames (frames, ticks, numValues, TimeScale::RationalPrecision);
+        errors = 0;
+        for (int i = 0; i < numValues; ++i)
+        {
+            uint64 single;
+            ts.ticksFromFrames (frames + i, &single, 1, TimeScale::RationalPrecision);
+            if (single != ticks[i])
+                ++errors;
+        }
+        expectEquals (errors, 0);
+
+        beginTest ("portable mulDivRound");
+        const uint64 maxValue = std::numeric_limits<uint64>::max();
+        expectEquals (mulDivRoundPortable (0, 12345, 7), (uint64) 0);
+        expectEquals (mulDivRoundPortable (1, 1, 2), (uint64) 1);
+        expectEquals (mulDivRoundPortable (4, 1, 3), (uint64) 1);
+        expectEquals (mulDivRoundPortable (5, 1, 3), (uint64) 2);
+        expectEquals (mulDivRoundPortable (maxValue, maxValue, maxValue), maxValue);
+        expectEquals (mulDivRoundPortable ((uint64) 1 << 63, 4, 8), (uint64) 1 << 62);
+        expectEquals (mulDivRoundPortable (((uint64) 1 << 40) + 3, ((uint64) 1 << 40) + 5, ((uint64) 1 << 40) + 7),
+                      (uint64) 1099511627777);
+        expectEquals (mulDivRoundPortable (0x123456789abcdefULL, 0xfedcba98ULL, 0x1000000007ULL),
+                      (uint64) 0x121fa00ac72582ULL);
+
+        // matches the native 128 bit path wherever the result fits
+        errors = 0;
+        for (int i = 0; i < 100000; ++i)
+        {
+            const uint64 a = (uint64) rng.nextInt64();
+            const uint64 b = (uint64) rng.nextInt64() >> rng.nextInt (64);
+            const uint64 c = jmax (b, (uint64) 1) + ((uint64) rng.nextInt64() >> rng.nextInt (64)) % 1000;
+            if (c < b)
+                continue;
+            if (mulDivRoundPortable (a, b, c) != mulDivRound (a, b, c))
+                ++errors;
+        }
+        expectEquals (errors, 0);
+    }
+
+    void testSnapshot (Random& rng)
+    {
+        beginTest ("snapshot conversions match");
+        TimeScale ts;
+        ts.setSampleRate (44100);
+        ts.updateScale();
+        for (int i = 1; i <= 200; ++i)
+            ts.addNode ((uint64) i * 44100 * 2, 80.0f + (float) (i % 50), 2, (unsigned short) (3 + i % 3));
+
+        const TimeScaleSnapshot::Ptr snapshot (new TimeScaleSnapshot (ts));
+        expectEquals (snapshot->getNumSegments(), ts.nodes().count());
+
+        TimeScaleSnapshot::Cursor cursor;
+        const TimeScale::Node* const last = ts.nodes().last();
+        int errors = 0;
+        for (int i = 0; i < 5000; ++i)
+        {
+            // alternate sequential and random positions
+            const uint64 frame = (i % 2 == 0) ? (uint64) i * 512
+                                              : (uint64) rng.nextInt64() % (last->frame + 100000);
+            const uint64 tick = (uint64) rng.nextInt64() % (last->tick + 10000);
+            const unsigned int beat = (unsigned int) rng.nextInt ((int) last->beat + 16);
+            const unsigned short bar = (unsigned short) rng.nextInt ((int) last->bar + 4);
+            const int pixel = rng.nextInt (last->pixel + 1000);
+
+            if (snapshot->tickFromFrame (frame, cursor) != ts.tickFromFrame (frame)) ++errors;
+            if (snapshot->frameFromTick (tick, cursor)  != ts.frameFromTick (tick))  ++errors;
+            if (snapshot->beatFromFrame (frame, cursor) != ts.beatFromFrame (frame)) ++errors;
+            if (snapshot->frameFromBeat (beat, cursor)  != ts.frameFromBeat (beat))  ++errors;
+            if (snapshot->barFromFrame (frame, cursor)  != ts.barFromFrame (frame))  ++errors;
+            if (snapshot->frameFromBar (bar, cursor)    != ts.frameFromBar (bar))    ++errors;
+            if (snapshot->pixelFromTick (tick, cursor)  != ts.pixelFromTick (tick))  ++errors;
+            if (snapshot->tickFromPixel (pixel, cursor) != ts.tickFromPixel (pixel)) ++errors;
+            if (snapshot->getTempoAtFrame (frame, cursor) != ts.cursor().seekFrame (frame)->tempo) ++errors;
+        }
+
+        expectEquals (errors, 0);
+
+        // batches of ascending ticks, some spanning several segments
+        HeapBlock<uint64> ticks (300), frames (300);
+        errors = 0;
+        for (int batch = 0; batch < 50; ++batch)
+        {
+            uint64 tick = (uint64) rng.nextInt64() % last->tick;
+            for (int i = 0; i < 300; ++i)
+                ticks[i] = (tick += (uint64) rng.nextInt (2000));
+
+            snapshot->framesFromTicks (ticks, frames, 300, cursor);
+            for (int i = 0; i < 300; ++i)
+                if (frames[i] != snapshot->frameFromTick (ticks[i], cursor))
+                    ++errors;
+        }
+        expectEquals (errors, 0);
+
+        // editing the source leaves the snapshot alone
+        const uint64 lastFrame = last->frame;
+        const uint64 before = snapshot->tickFromFrame (lastFrame, cursor);
+        ts.setTempo (200.0f);
+        ts.updateScale();
+        expect (ts.tickFromFrame (lastFrame) != before);
+        expectEquals (snapshot->tickFromFrame (lastFrame, cursor), before);
+    }
+
+    /** Publishes tempo maps with a single tempo, the reader checks every
+        snapshot it sees is internally consistent */
+    struct Reader : public Thread
+    {
+        Reader (RealtimeTimeScale& r) : Thread ("reader"), realtime (r) { }
+
+        void run() override
+        {
+            TimeScaleSnapshot::Cursor cursor;
+            while (! threadShouldExit())
+            {
+                const TimeScaleSnapshot* const snapshot = realtime.acquire();
+                if (snapshot == nullptr)
+                    continue;
+
+                const float tempo = snapshot->getTempoAtFrame (0, cursor);
+                for (uint64 frame = 0; frame < 10 * 44100; frame += 4410)
+                {
+                    if (snapshot->getTempoAtFrame (frame, cursor) != tempo)
+                        ++errors;
+                    // with one tempo, ticks are linear in frames
+                    const uint64 expected = (uint64) TimeScale::uroundf (
+                        (tempo * snapshot->ticksPerBeat() * frame) / (60.0f * 44100.0f));
+                    if (snapshot->tickFromFrame (frame, cursor) != expected)
+                        ++errors;
+                }
+                ++reads;
+            }
+        }
+
+        RealtimeTimeScale& realtime;
+        int errors = 0;
+        std::atomic<int> reads { 0 };
+    };
+
+    void testRealtime()
+    {
+        beginTest ("realtime publish and acquire");
+        RealtimeTimeScale realtime;
+        Reader reader (realtime);
+        reader.startThread();
+
+        TimeScale ts;
+        ts.setSampleRate (44100);
+        for (int i = 0; i < 500; ++i)
+        {
+            ts.setTempo (60.0f + (float) (i % 100));
+            ts.updateScale();
+            realtime.publish (ts);
+            if (i % 50 == 0)
+                Thread::sleep (1);
+        }
+
+        const uint32 startTime = Time::getMillisecondCounter();
+        while (reader.reads.load() < 10 && Time::getMillisecondCounter() - startTime < 5000)
+            Thread::sleep (1);
+        reader.stopThread (1000);
+
+        expect (reader.reads.load() > 0);
+        expectEquals (reader.errors, 0);
+        TimeScaleSnapshot::Cursor cursor;
+        expect (realtime.getLatest() != nullptr);
+        expectEquals (realtime.getLatest()->getTempoAtFrame (0, cursor), 159.0f);
+    }
+};
+
+static TimeScaleTests sTimeScaleTests;
+
+/** Compares random seeks through the segment index with a list walk.
+    Run it on its own with: UnitTests "TimeScale Benchmark" */
+class TimeScaleBenchmark : public UnitTest
+{
+public:
+    TimeScaleBenchmark() : UnitTest ("TimeScale Benchmark") { }
+
+    void runTest() override
+    {
+        beginTest ("random seeks");
+        TimeScale ts;
+        ts.setSampleRate (48000);
+        ts.updateScale();
+        for (int i = 1; i <= 5000; ++i)
+            ts.addNode ((uint64) i * 48000 * 4, 60.0f + (float) (i % 120));
+
+        const uint64 maxFrame = ts.nodes().last()->frame;
+        Random rng (42);
+        Array<uint64> frames;
+        for (int i = 0; i < 20000; ++i)
+            frames.add ((uint64) rng.nextInt64() % maxFrame);
+
+        uint64 sum = 0;
+        int64 start = Time::getHighResolutionTicks();
+        for (const auto frame : frames)
+            sum += ts.tickFromFrame (frame);
+        const double indexed = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - start);
+
+        start = Time::getHighResolutionTicks();
+        for (const auto frame : frames)
+        {
+            const TimeScale::Node* found = ts.nodes().first();
+            for (const TimeScale::Node* node = found; node != nullptr && node->frame <= frame; node = node->next())
+                found = node;
+            sum -= found->tickFromFrame (frame);
+        }
+        const double walked = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - start);
+
+        expectEquals (sum, (uint64) 0);
+        logMessage ("indexed (ms): " + String (indexed * 1000.0, 3) + "  list walk (ms): " + String (walked * 1000.0, 3));
+    }
+};
+
+static TimeScaleBenchmark sTimeScaleBenchmark;
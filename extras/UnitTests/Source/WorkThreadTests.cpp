@@ -0,0 +1,448 @@
+/*
+    This file is part of the Kushview Modules for JUCE
+    Copyright (c) 2014-2019  Kushview, LLC.  All rights reserved.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+class WorkThreadTests : public UnitTest
+{
+public:
+    WorkThreadTests() : UnitTest ("WorkThread") { }
+
+    enum { numProducers = 4, numMessages = 5000 };
+
+    /** Message layout: producer, sequence, length, then 'length' pattern bytes */
+    static uint32 writeMessage (uint8* dest, uint32 producer, uint32 sequence, uint32 maxLength = 200)
+    {
+        const uint32 length = 1 + ((producer * 31 + sequence * 7) % maxLength);
+        uint32* const header = reinterpret_cast<uint32*> (dest);
+        header[0] = producer;
+        header[1] = sequence;
+        header[2] = length;
+        for (uint32 i = 0; i < length; ++i)
+            dest[12 + i] = static_cast<uint8> (producer + sequence + i);
+        return 12 + length;
+    }
+
+    static bool isIntact (uint32 size, const uint8* data, uint32& producer, uint32& sequence)
+    {
+        if (size < 12)
+            return false;
+        // messages are packed, so the header may not be aligned
+        uint32 header[3];
+        memcpy (header, data, sizeof (header));
+        producer = header[0];
+        sequence = header[1];
+        if (producer >= numProducers || size != 12 + header[2])
+            return false;
+        for (uint32 i = 0; i < header[2]; ++i)
+            if (data[12 + i] != static_cast<uint8> (producer + sequence + i))
+                return false;
+        return true;
+    }
+
+    struct Producer : public Thread
+    {
+        Producer (std::function<bool(const void*, uint32)> w, uint32 i)
+            : Thread ("producer"), write (w), index (i) { }
+
+        void run() override
+        {
+            HeapBlock<uint8> message (256);
+            for (uint32 seq = 0; seq < numMessages; ++seq)
+            {
+                const uint32 size = writeMessage (message.getData(), index, seq);
+                while (! write (message.getData(), size))
+                    Thread::yield();
+            }
+        }
+
+        std::function<bool(const void*, uint32)> write;
+        const uint32 index;
+    };
+
+    struct Checker : public WorkerBase
+    {
+        Checker (WorkThread& t) : WorkerBase (t, 64) { }
+        Checker (WorkThreadPool& p) : WorkerBase (p, 64) { }
+
+        void processRequest (uint32 size, const void* data) override
+        {
+            uint32 producer, sequence;
+            if (! isIntact (size, static_cast<const uint8*> (data), producer, sequence)
+                || sequence != nextSequence [producer])
+                ++errors;
+            else
+                ++nextSequence [producer];
+            ++received;
+        }
+
+        void processResponse (uint32, const void*) override { }
+
+        uint32 nextSequence [numProducers] = { 0 };
+        std::atomic<int> received { 0 };
+        int errors = 0;
+    };
+
+    void runTest() override
+    {
+        testRingBuffer();
+        testWorkThread();
+        testThreadPool();
+        testStaleWorkerIds();
+        testWorkerLimit();
+        testBatchedResponses();
+    }
+
+    void testRingBuffer()
+    {
+        beginTest ("multi producer ring buffer");
+        MultiProducerRingBuffer ring (4096);
+        OwnedArray<Producer> producers;
+        for (uint32 i = 0; i < numProducers; ++i)
+            producers.add (new Producer ([&ring, i](const void* d, uint32 s) { return ring.write (i, d, s); }, i));
+        for (auto* p : producers)
+            p->startThread();
+
+        HeapBlock<uint8> buffer (256);
+        uint32 nextSequence [numProducers] = { 0 };
+        int errors = 0, received = 0;
+        const uint32 startTime = Time::getMillisecondCounter();
+
+        while (received < numProducers * numMessages && Time::getMillisecondCounter() - startTime < 20000)
+        {
+            uint32 size = 0, tag = 0;
+            if (! ring.peek (size, tag))
+            {
+                Thread::yield();
+                continue;
+            }
+
+            uint32 producer, sequence;
+            if (ring.read (buffer.getData(), 256) != size
+                || ! isIntact (size, buffer.getData(), producer, sequence)
+                || producer != tag || sequence != nextSequence [producer])
+                ++errors;
+            else
+                ++nextSequence [producer];
+            ++received;
+        }
+
+        for (auto* p : producers)
+            p->stopThread (1000);
+
+        expectEquals (received, (int) (numProducers * numMessages));
+        expectEquals (errors, 0);
+    }
+
+    void testWorkThread()
+    {
+        beginTest ("schedule work from many threads");
+        WorkThread thread ("test", 4096);
+        Checker checker (thread);
+        OwnedArray<Producer> producers;
+        for (uint32 i = 0; i < numProducers; ++i)
+            producers.add (new Producer ([&checker](const void* d, uint32 s) { return checker.scheduleWork (s, d); }, i));
+        for (auto* p : producers)
+            p->startThread();
+
+        const uint32 startTime = Time::getMillisecondCounter();
+        while (checker.received.load() < numProducers * numMessages && Time::getMillisecondCounter() - startTime < 20000)
+            Thread::sleep (2);
+
+        for (auto* p : producers)
+            p->stopThread (1000);
+
+        expectEquals (checker.received.load(), (int) (numProducers * numMessages));
+        expectEquals (checker.errors, 0);
+    }
+
+    void testThreadPool()
+    {
+        beginTest ("thread pool keeps per worker order");
+        WorkThreadPool pool ("test", 3, 4096);
+        OwnedArray<Checker> checkers;
+        for (int i = 0; i < 6; ++i)
+            checkers.add (new Checker (pool));
+
+        for (int i = 0; i < pool.getNumThreads(); ++i)
+            expectEquals (pool.getThread(i)->getNumWorkers(), 2);
+
+        HeapBlock<uint8> message (256);
+        for (uint32 seq = 0; seq < 1000; ++seq)
+        {
+            for (uint32 p = 0; p < numProducers; ++p)
+            {
+                const uint32 size = writeMessage (message.getData(), p, seq);
+                for (auto* checker : checkers)
+                    while (! checker->scheduleWork (size, message.getData()))
+                        Thread::yield();
+            }
+        }
+
+        const uint32 startTime = Time::getMillisecondCounter();
+        for (auto* checker : checkers)
+            while (checker->received.load() < numProducers * 1000 && Time::getMillisecondCounter() - startTime < 20000)
+                Thread::sleep (2);
+
+        for (auto* checker : checkers)
+        {
+            expectEquals (checker->received.load(), (int) (numProducers * 1000));
+            expectEquals (checker->errors, 0);
+        }
+
+        checkers.clear();
+
+        beginTest ("thread pool spreads workers created at once");
+        struct Creator : public Thread
+        {
+            Creator (WorkThreadPool& p, std::atomic<bool>& g)
+                : Thread ("creator"), pool (p), go (g) { }
+
+            void run() override
+            {
+                while (! go.load())
+                    Thread::yield();
+                for (int i = 0; i < 4; ++i)
+                    workers.add (new Checker (pool));
+            }
+
+            WorkThreadPool& pool;
+            std::atomic<bool>& go;
+            OwnedArray<Checker> workers;
+        };
+
+        std::atomic<bool> go { false };
+        OwnedArray<Creator> creators;
+        for (int i = 0; i < 6; ++i)
+            creators.add (new Creator (pool, go));
+        for (auto* c : creators)
+            c->startThread();
+        go = true;
+        for (auto* c : creators)
+            c->stopThread (5000);
+
+        for (int i = 0; i < pool.getNumThreads(); ++i)
+            expectEquals (pool.getThread(i)->getNumWorkers(), 8);
+
+        creators.clear();
+    }
+
+    struct Gate : public WorkerBase
+    {
+        Gate (WorkThread& t) : WorkerBase (t, 64) { }
+        void processRequest (uint32, const void*) override
+        {
+            entered = true;
+            while (! open.load())
+                Thread::yield();
+        }
+        void processResponse (uint32, const void*) override { }
+        std::atomic<bool> entered { false }, open { false };
+    };
+
+    void testStaleWorkerIds()
+    {
+        beginTest ("requests for a removed worker are dropped");
+        WorkThread thread ("test", 4096);
+        Gate gate (thread);
+        HeapBlock<uint8> message (256);
+        const uint32 size = writeMessage (message.getData(), 0, 0);
+
+        // hold the thread so requests stay queued
+        expect (gate.scheduleWork (size, message.getData()));
+        while (! gate.entered.load())
+            Thread::yield();
+
+        ScopedPointer<Checker> removed (new Checker (thread));
+        for (int i = 0; i < 10; ++i)
+            expect (removed->scheduleWork (size, message.getData()));
+        removed = nullptr;
+
+        // takes over the removed worker's slot
+        Checker replacement (thread);
+        expectEquals (thread.getNumWorkers(), 2);
+
+        gate.open = true;
+        expect (replacement.scheduleWork (size, message.getData()));
+
+        const uint32 startTime = Time::getMillisecondCounter();
+        while (replacement.received.load() < 1 && Time::getMillisecondCounter() - startTime < 5000)
+            Thread::sleep (2);
+        Thread::sleep (10);
+
+        expectEquals (replacement.received.load(), 1);
+        expectEquals (replacement.errors, 0);
+    }
+
+    void testWorkerLimit()
+    {
+        beginTest ("workers past the id limit are refused");
+        WorkThread thread ("test", 4096);
+        OwnedArray<Checker> workers;
+        for (int i = 0; i < 65536; ++i)
+            workers.add (new Checker (thread));
+        expectEquals (thread.getNumWorkers(), 65536);
+
+        HeapBlock<uint8> message (256);
+        const uint32 size = writeMessage (message.getData(), 0, 0);
+        {
+            Checker extra (thread);
+            expectEquals (thread.getNumWorkers(), 65536);
+            expect (! extra.scheduleWork (size, message.getData()));
+        }
+
+        // a freed slot can be used again
+        workers.remove (100);
+        Checker replacement (thread);
+        expectEquals (thread.getNumWorkers(), 65536);
+        expect (replacement.scheduleWork (size, message.getData()));
+
+        const uint32 startTime = Time::getMillisecondCounter();
+        while (replacement.received.load() < 1 && Time::getMillisecondCounter() - startTime < 5000)
+            Thread::sleep (2);
+        expectEquals (replacement.received.load(), 1);
+    }
+
+    struct Responder : public WorkerBase
+    {
+        Responder (WorkThread& t) : WorkerBase (t, 256) { }
+
+        void processRequest (uint32 size, const void* data) override
+        {
+            if (! respondToWork (size, data))
+                ++errors;
+            ++requests;
+        }
+
+        void processResponse (uint32 size, const void* data) override
+        {
+            uint32 producer, sequence;
+            if (! isIntact (size, static_cast<const uint8*> (data), producer, sequence)
+                || sequence != nextSequence)
+                ++errors;
+            else
+                ++nextSequence;
+        }
+
+        std::atomic<int> requests { 0 };
+        uint32 nextSequence = 0;
+        int errors = 0;
+    };
+
+    void testBatchedResponses()
+    {
+        beginTest ("batched responses");
+        WorkThread thread ("test", 4096);
+        Responder responder (thread);
+        HeapBlock<uint8> message (256);
+        uint32 sequence = 0;
+
+        // rounds of five, so the small response ring wraps many times
+        for (int round = 0; round < 200; ++round)
+        {
+            uint32 bytes = 0;
+            for (int i = 0; i < 5; ++i)
+            {
+                const uint32 size = writeMessage (message.getData(), 0, sequence++, 30);
+                bytes += size;
+                expect (responder.scheduleWork (size, message.getData()));
+            }
+
+            const uint32 startTime = Time::getMillisecondCounter();
+            while (responder.requests.load() < (round + 1) * 5 && Time::getMillisecondCounter() - startTime < 5000)
+                Thread::yield();
+
+            expectEquals (responder.processWorkResponses (2), 2);
+            expectEquals (responder.processWorkResponses (0, 1), 1);
+            expectEquals (responder.processWorkResponses (0, bytes), 2);
+            expectEquals (responder.processWorkResponses(), 0);
+        }
+
+        expectEquals ((int) responder.nextSequence, 1000);
+        expectEquals (responder.errors, 0);
+    }
+};
+
+static WorkThreadTests sWorkThreadTests;
+
+/** Measures the schedule -> processRequest -> processResponse round trip.
+    Run it on its own with: UnitTests "WorkThread Latency" */
+class WorkThreadLatencyBenchmark : public UnitTest
+{
+public:
+    WorkThreadLatencyBenchmark() : UnitTest ("WorkThread Latency") { }
+
+    struct Echo : public WorkerBase
+    {
+        Echo (WorkThread& t) : WorkerBase (t, 1024) { }
+
+        void processRequest (uint32 size, const void* data) override
+        {
+            respondToWork (size, data);
+        }
+
+        void processResponse (uint32 size, const void* data) override
+        {
+            if (size == sizeof (int64))
+                memcpy (&lastResponse, data, sizeof (int64));
+        }
+
+        int64 lastResponse = 0;
+    };
+
+    void runTest() override
+    {
+        beginTest ("round trip latency");
+        WorkThread thread ("latency", 4096, 8);
+        Echo echo (thread);
+
+        const int numRounds = 2000;
+        Array<double> micros;
+        micros.ensureStorageAllocated (numRounds);
+        const double ticksPerMicro = (double) Time::getHighResolutionTicksPerSecond() / 1000000.0;
+
+        for (int i = 0; i < numRounds; ++i)
+        {
+            const int64 start = Time::getHighResolutionTicks();
+            expect (echo.scheduleWork (sizeof (start), &start));
+
+            // stand in for the realtime thread polling for responses
+            while (echo.lastResponse != start)
+            {
+                echo.processWorkResponses();
+                if ((double) (Time::getHighResolutionTicks() - start) / ticksPerMicro > 1000000.0)
+                    break;
+            }
+
+            micros.add ((double) (Time::getHighResolutionTicks() - start) / ticksPerMicro);
+        }
+
+        expectEquals (micros.size(), numRounds);
+        std::sort (micros.begin(), micros.end());
+
+        double total = 0.0;
+        for (const auto us : micros)
+            total += us;
+
+        logMessage (String ("round trip (us): mean ") + String (total / (double) numRounds, 2)
+            + "  median " + String (micros [numRounds / 2], 2)
+            + "  p99 "    + String (micros [(numRounds * 99) / 100], 2)
+            + "  max "    + String (micros.getLast(), 2));
+    }
+};
+
+static WorkThreadLatencyBenchmark sWorkThreadLatencyBenchmark;
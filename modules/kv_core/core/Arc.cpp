@@ -21,3 +21,104 @@ Arc::Arc (uint32 sn, uint32 sp, uint32 dn, uint32 dp) noexcept
     : sourceNode (sn), sourcePort (sp),
       destNode (dn), destPort (dp)
 { }
+
+static_assert (sizeof (ArcData) == 16, "ArcData should be a packed 16 byte record");
+
+namespace ArcListHelpers
+{
+    inline bool sourceFirst (const ArcData& a, const ArcData& b) noexcept
+    {
+        return ArcSorter::compareElements (a, b) < 0;
+    }
+
+    inline bool destFirst (const ArcData& a, const ArcData& b) noexcept
+    {
+        if (a.destNode   != b.destNode)     return a.destNode   < b.destNode;
+        if (a.sourceNode != b.sourceNode)   return a.sourceNode < b.sourceNode;
+        if (a.destPort   != b.destPort)     return a.destPort   < b.destPort;
+        return a.sourcePort < b.sourcePort;
+    }
+
+    inline bool sourceBefore (const ArcData& a, uint32 node) noexcept { return a.sourceNode < node; }
+    inline bool sourceAfter (uint32 node, const ArcData& a) noexcept  { return node < a.sourceNode; }
+    inline bool destBefore (const ArcData& a, uint32 node) noexcept   { return a.destNode < node; }
+    inline bool destAfter (uint32 node, const ArcData& a) noexcept    { return node < a.destNode; }
+}
+
+bool ArcList::add (const ArcData& arc)
+{
+    using namespace ArcListHelpers;
+    const ArcData* const source = std::lower_bound (bySource.begin(), bySource.end(), arc, sourceFirst);
+    if (source != bySource.end() && *source == arc)
+        return false;
+
+    const ArcData* const dest = std::lower_bound (byDest.begin(), byDest.end(), arc, destFirst);
+    bySource.insert ((int) (source - bySource.begin()), arc);
+    byDest.insert ((int) (dest - byDest.begin()), arc);
+    return true;
+}
+
+bool ArcList::remove (const ArcData& arc)
+{
+    using namespace ArcListHelpers;
+    const int index = indexOf (arc);
+    if (index < 0)
+        return false;
+
+    const ArcData* const dest = std::lower_bound (byDest.begin(), byDest.end(), arc, destFirst);
+    jassert (dest != byDest.end() && *dest == arc);
+    bySource.remove (index);
+    byDest.remove ((int) (dest - byDest.begin()));
+    return true;
+}
+
+void ArcList::removeNode (uint32 node)
+{
+    auto touches = [node] (const ArcData& a) { return a.sourceNode == node || a.destNode == node; };
+    for (Array<ArcData>* arcs : { &bySource, &byDest })
+    {
+        ArcData* const data = arcs->getRawDataPointer();
+        arcs->resize ((int) (std::remove_if (data, data + arcs->size(), touches) - data));
+    }
+}
+
+void ArcList::clear()
+{
+    bySource.clearQuick();
+    byDest.clearQuick();
+}
+
+int ArcList::indexOf (const ArcData& arc) const noexcept
+{
+    const ArcData* const found = std::lower_bound (bySource.begin(), bySource.end(), arc,
+                                                   ArcListHelpers::sourceFirst);
+    return (found != bySource.end() && *found == arc) ? (int) (found - bySource.begin()) : -1;
+}
+
+Range<int> ArcList::getRangeFrom (uint32 node) const noexcept
+{
+    using namespace ArcListHelpers;
+    const ArcData* const first = std::lower_bound (bySource.begin(), bySource.end(), node, sourceBefore);
+    const ArcData* const last  = std::upper_bound (first, bySource.end(), node, sourceAfter);
+    return Range<int> ((int) (first - bySource.begin()), (int) (last - bySource.begin()));
+}
+
+Range<int> ArcList::getRangeTo (uint32 node) const noexcept
+{
+    using namespace ArcListHelpers;
+    const ArcData* const first = std::lower_bound (byDest.begin(), byDest.end(), node, destBefore);
+    const ArcData* const last  = std::upper_bound (first, byDest.end(), node, destAfter);
+    return Range<int> ((int) (first - byDest.begin()), (int) (last - byDest.begin()));
+}
+
+void ArcList::sortAndRemoveDuplicates()
+{
+    using namespace ArcListHelpers;
+    ArcData* const data = bySource.getRawDataPointer();
+    std::sort (data, data + bySource.size(), sourceFirst);
+    bySource.resize ((int) (std::unique (data, data + bySource.size()) - data));
+
+    byDest = bySource;
+    ArcData* const dest = byDest.getRawDataPointer();
+    std::sort (dest, dest + byDest.size(), destFirst);
+}
@@ -19,6 +19,24 @@
 
 #pragma once
 
+/** A plain arc record. Unlike Arc it has no vtable or leak detector, so
+    it packs into 16 bytes and arrays of them need no per arc allocation */
+struct ArcData
+{
+    uint32 sourceNode;
+    uint32 sourcePort;
+    uint32 destNode;
+    uint32 destPort;
+
+    inline bool operator== (const ArcData& o) const noexcept
+    {
+        return sourceNode == o.sourceNode && sourcePort == o.sourcePort
+            && destNode == o.destNode && destPort == o.destPort;
+    }
+
+    inline bool operator!= (const ArcData& o) const noexcept { return ! operator== (o); }
+};
+
 struct JUCE_API Arc
 {
 public:
@@ -65,72 +83,425 @@ struct ArcSorter
 
         return 0;
     }
+
+    static inline int compareElements (const ArcData& first, const ArcData& second) noexcept
+    {
+        if (first.sourceNode < second.sourceNode)      return -1;
+        if (first.sourceNode > second.sourceNode)      return 1;
+        if (first.destNode   < second.destNode)        return -1;
+        if (first.destNode   > second.destNode)        return 1;
+        if (first.sourcePort < second.sourcePort)      return -1;
+        if (first.sourcePort > second.sourcePort)      return 1;
+        if (first.destPort   < second.destPort)        return -1;
+        if (first.destPort   > second.destPort)        return 1;
+
+        return 0;
+    }
+};
+
+/** A flat, sorted set of arcs.
+
+    Arcs are stored by value in two packed arrays: one sorted per ArcSorter
+    and one sorted by destination. All arcs from a node, or to a node, are a
+    contiguous run found with a binary search, so walking a node's
+    connections reads memory in order. Duplicate arcs are ignored. */
+class JUCE_API ArcList
+{
+public:
+    ArcList() { }
+
+    template<class ArcType>
+    explicit ArcList (const OwnedArray<ArcType>& arcs) { addArray (arcs); }
+
+    /** Returns the number of arcs */
+    inline int size() const noexcept { return bySource.size(); }
+
+    /** Returns true if there are no arcs */
+    inline bool isEmpty() const noexcept { return bySource.size() == 0; }
+
+    /** Returns an arc in ArcSorter order */
+    inline const ArcData& getUnchecked (int index) const noexcept { return bySource.getReference (index); }
+    inline const ArcData& operator[] (int index) const noexcept { return getUnchecked (index); }
+
+    inline const ArcData* begin() const noexcept { return bySource.begin(); }
+    inline const ArcData* end() const noexcept { return bySource.end(); }
+
+    /** Add an arc. Returns false if it was already in the list */
+    bool add (const ArcData& arc);
+    bool add (uint32 sourceNode, uint32 sourcePort, uint32 destNode, uint32 destPort)
+    {
+        const ArcData arc = { sourceNode, sourcePort, destNode, destPort };
+        return add (arc);
+    }
+
+    /** Add many arcs, sorting once at the end */
+    template<class ArcType>
+    void addArray (const OwnedArray<ArcType>& arcs)
+    {
+        bySource.ensureStorageAllocated (bySource.size() + arcs.size());
+        for (int i = 0; i < arcs.size(); ++i)
+        {
+            const ArcType* const c = arcs.getUnchecked (i);
+            const ArcData arc = { c->sourceNode, c->sourcePort, c->destNode, c->destPort };
+            bySource.add (arc);
+        }
+
+        sortAndRemoveDuplicates();
+    }
+
+    /** Remove an arc. Returns false if it wasn't in the list */
+    bool remove (const ArcData& arc);
+
+    /** Remove all arcs from or to a node */
+    void removeNode (uint32 node);
+
+    /** Remove all arcs */
+    void clear();
+
+    /** Returns the ArcSorter order index of an arc, or -1 */
+    int indexOf (const ArcData& arc) const noexcept;
+    inline bool contains (const ArcData& arc) const noexcept { return indexOf (arc) >= 0; }
+
+    /** Returns the indexes of the arcs from a node, for getUnchecked() */
+    Range<int> getRangeFrom (uint32 node) const noexcept;
+
+    /** Returns the indexes of the arcs to a node, for getArcTo() */
+    Range<int> getRangeTo (uint32 node) const noexcept;
+
+    /** Returns an arc in destination order */
+    inline const ArcData& getArcTo (int index) const noexcept { return byDest.getReference (index); }
+
+private:
+    Array<ArcData> bySource;
+    Array<ArcData> byDest;
+
+    void sortAndRemoveDuplicates();
 };
 
-/** Holds a fast lookup table for checking which arcs are inputs to others. */
+/** Holds a fast lookup table for checking which arcs are inputs to others.
+
+    Nodes are kept in a topological order which is repaired locally as arcs
+    are added (Pearce-Kelly), so adding an arc only visits the nodes ordered
+    between its two ends, and removing one never breaks the order.
+    isAnInputTo() only searches nodes ordered between the two nodes asked
+    about. While arcs form a cycle, queries fall back to a plain search.
+
+    Queries keep visit marks in the table, so don't query the same table
+    from more than one thread at a time. */
 template<class ArcType> class ArcTable
 {
 public:
+    ArcTable() { }
+
     explicit ArcTable (const OwnedArray<ArcType>& arcs)
     {
         for (int i = 0; i < arcs.size(); ++i)
         {
             const ArcType* const c = arcs.getUnchecked(i);
+            addArc (c->sourceNode, c->destNode);
+        }
+    }
 
-            int index;
-            Entry* entry = findEntry (c->destNode, index);
+    explicit ArcTable (const ArcList& arcs)
+    {
+        for (const ArcData& arc : arcs)
+            addArc (arc.sourceNode, arc.destNode);
+    }
 
-            if (entry == nullptr)
-            {
-                entry = new Entry (c->destNode);
-                entries.insert (index, entry);
-            }
+    /** Add an arc between two nodes. Parallel arcs are counted.
+        @returns false if the arc closes a cycle, it is still added */
+    bool addArc (const uint32 sourceNode, const uint32 destNode)
+    {
+        Entry* const source = getOrCreateEntry (sourceNode);
+        Entry* const dest   = getOrCreateEntry (destNode);
+        ++numArcs;
+
+        bool exists;
+        const int index = indexOfLink (source->outputs, dest, exists);
+        if (exists)
+        {
+            Link& link = source->outputs.getReference (index);
+            ++link.count;
+            ++dest->inputs.getReference (indexOfLink (dest->inputs, source, exists)).count;
+            return ! wouldCreateCycle (sourceNode, destNode);
+        }
+
+        const bool ordered = source != dest && (source->order < dest->order || reorder (source, dest));
+
+        // the order only covers acyclic links, existing cycles need a full search
+        const bool closesCycle = ! ordered || (cyclicArcs.size() > 0 && isAnInputTo (destNode, sourceNode));
+
+        source->outputs.insert (index, Link (dest, ! ordered));
+        dest->inputs.insert (indexOfLink (dest->inputs, source, exists), Link (source, false));
 
-            entry->srcNodes.add (c->sourceNode);
+        if (! ordered)
+            cyclicArcs.add (CyclicArc (source, dest));
+        return ! closesCycle;
+    }
+
+    /** Remove one arc between two nodes.
+        @returns false if there was no such arc */
+    bool removeArc (const uint32 sourceNode, const uint32 destNode)
+    {
+        int sourceIndex, destIndex;
+        Entry* const source = findEntry (sourceNode, sourceIndex);
+        Entry* const dest   = findEntry (destNode, destIndex);
+        if (source == nullptr || dest == nullptr)
+            return false;
+
+        bool exists;
+        const int index = indexOfLink (source->outputs, dest, exists);
+        if (! exists)
+            return false;
+
+        --numArcs;
+        const int inputIndex = indexOfLink (dest->inputs, source, exists);
+        Link& link = source->outputs.getReference (index);
+        if (--link.count > 0)
+        {
+            --dest->inputs.getReference (inputIndex).count;
+            return true;
         }
+
+        const bool wasCyclic = link.cyclic;
+        source->outputs.remove (index);
+        dest->inputs.remove (inputIndex);
+
+        if (wasCyclic)
+            cyclicArcs.removeFirstMatchingValue (CyclicArc (source, dest));
+        if (cyclicArcs.size() > 0)
+            retryCyclicArcs();
+
+        removeIfUnused (source);
+        if (dest != source)
+            removeIfUnused (dest);
+        return true;
     }
 
+    /** Returns true if there is a path of arcs from possibleInputId to
+        possibleDestinationId */
     bool isAnInputTo (const uint32 possibleInputId,
                       const uint32 possibleDestinationId) const noexcept
     {
-        return isAnInputToRecursive (possibleInputId, possibleDestinationId, entries.size());
+        int index;
+        const Entry* const input = findEntry (possibleInputId, index);
+        const Entry* const dest  = findEntry (possibleDestinationId, index);
+        if (input == nullptr || dest == nullptr)
+            return false;
+
+        // Without cycles, every path runs forwards in the order.
+        const bool pruned = cyclicArcs.size() == 0;
+        if (pruned && input->order >= dest->order)
+            return false;
+
+        const uint32 mark = nextMark();
+        Array<const Entry*>& stack = searchStack;
+        stack.clearQuick();
+        for (const Link& link : input->outputs)
+            stack.add (link.entry);
+
+        while (stack.size() > 0)
+        {
+            const Entry* const entry = stack.removeAndReturn (stack.size() - 1);
+            if (entry == dest)
+                return true;
+            if (entry->mark == mark || (pruned && entry->order > dest->order))
+                continue;
+
+            entry->mark = mark;
+            for (const Link& link : entry->outputs)
+                if (link.entry->mark != mark)
+                    stack.add (link.entry);
+        }
+
+        return false;
     }
 
+    /** Returns true if an arc from sourceNode to destNode would close a cycle */
+    bool wouldCreateCycle (const uint32 sourceNode, const uint32 destNode) const noexcept
+    {
+        return sourceNode == destNode || isAnInputTo (destNode, sourceNode);
+    }
+
+    /** Returns true if the arcs currently form at least one cycle */
+    bool hasCycles() const noexcept { return cyclicArcs.size() > 0; }
+
+    /** Returns the number of nodes with at least one arc */
+    int getNumNodes() const noexcept { return entries.size(); }
+
+    /** Returns the number of arcs, counting parallel arcs */
+    int getNumArcs() const noexcept { return numArcs; }
+
 private:
+    struct Entry;
+
+    struct Link
+    {
+        Link (Entry* e, bool c) noexcept : entry (e), count (1), cyclic (c) { }
+        Entry* entry;
+        int count;
+        bool cyclic;    ///< set on output links which close a cycle
+    };
+
     struct Entry
     {
-        explicit Entry (const uint32 destNode_) noexcept : destNode (destNode_) {}
+        explicit Entry (const uint32 nodeId_, const int order_) noexcept
+            : nodeId (nodeId_), order (order_), mark (0) {}
 
-        const uint32 destNode;
-        SortedSet<uint32> srcNodes;
+        const uint32 nodeId;
+        int order;
+        mutable uint32 mark;
+        Array<Link> inputs, outputs;    ///< sorted by node id
 
         JUCE_DECLARE_NON_COPYABLE (Entry)
     };
 
+    struct CyclicArc
+    {
+        CyclicArc (Entry* s, Entry* d) noexcept : source (s), dest (d) { }
+        bool operator== (const CyclicArc& o) const noexcept { return source == o.source && dest == o.dest; }
+        Entry* source;
+        Entry* dest;
+    };
+
     OwnedArray<Entry> entries;
+    Array<CyclicArc> cyclicArcs;
+    int numArcs = 0;
+    int nextOrder = 0;
+    mutable uint32 lastMark = 0;
+    mutable Array<const Entry*> searchStack;
 
-    bool isAnInputToRecursive (const uint32 possibleInputId,
-                               const uint32 possibleDestinationId,
-                               int recursionCheck) const noexcept
+    uint32 nextMark() const noexcept
     {
-        int index;
+        if (++lastMark == 0)
+        {
+            for (auto* entry : entries)
+                entry->mark = 0;
+            lastMark = 1;
+        }
+
+        return lastMark;
+    }
 
-        if (const Entry* const entry = findEntry (possibleDestinationId, index))
+    static int indexOfLink (const Array<Link>& links, const Entry* entry, bool& exists) noexcept
+    {
+        int start = 0, end = links.size();
+        while (start < end)
         {
-            const SortedSet<uint32>& srcNodes = entry->srcNodes;
+            const int halfway = (start + end) / 2;
+            if (links.getReference (halfway).entry->nodeId < entry->nodeId)
+                start = halfway + 1;
+            else
+                end = halfway;
+        }
 
-            if (srcNodes.contains (possibleInputId))
-                return true;
+        exists = start < links.size() && links.getReference (start).entry == entry;
+        return start;
+    }
+
+    Entry* getOrCreateEntry (const uint32 nodeId)
+    {
+        int index;
+        if (Entry* const entry = findEntry (nodeId, index))
+            return entry;
+        Entry* const entry = new Entry (nodeId, nextOrder++);
+        entries.insert (index, entry);
+        return entry;
+    }
+
+    void removeIfUnused (Entry* entry)
+    {
+        if (entry->inputs.size() > 0 || entry->outputs.size() > 0)
+            return;
 
-            if (--recursionCheck >= 0)
+        int index;
+        if (findEntry (entry->nodeId, index) == entry)
+            entries.remove (index);
+    }
+
+    /** Collect the nodes reachable from start without passing the bound.
+        Forwards follows outputs to nodes ordered before bound, backwards
+        follows inputs to nodes ordered after it. Cyclic links are ignored.
+        @returns false if the forward search reached stop */
+    bool collect (Entry* start, const Entry* stop, const uint32 mark,
+                  const int bound, const bool forwards, Array<Entry*>& found)
+    {
+        Array<Entry*> stack;
+        stack.add (start);
+        start->mark = mark;
+
+        while (stack.size() > 0)
+        {
+            Entry* const entry = stack.removeAndReturn (stack.size() - 1);
+            found.add (entry);
+
+            for (const Link& link : forwards ? entry->outputs : entry->inputs)
             {
-                for (int i = 0; i < srcNodes.size(); ++i)
-                    if (isAnInputToRecursive (possibleInputId, srcNodes.getUnchecked(i), recursionCheck))
-                        return true;
+                Entry* const next = link.entry;
+                if (link.cyclic)
+                    continue;
+                if (forwards && next == stop)
+                    return false;
+                if (next->mark == mark)
+                    continue;
+                if (forwards ? next->order >= bound : next->order <= bound)
+                    continue;
+
+                next->mark = mark;
+                stack.add (next);
             }
         }
 
-        return false;
+        return true;
+    }
+
+    struct OrderSorter
+    {
+        static int compareElements (const Entry* a, const Entry* b) noexcept { return a->order - b->order; }
+    };
+
+    /** Make room for an arc from source to dest where dest is ordered first.
+        Only nodes ordered between the two are touched.
+        @returns false if dest already reaches source */
+    bool reorder (Entry* source, Entry* dest)
+    {
+        const uint32 mark = nextMark();
+        Array<Entry*> forward, backward;
+        if (! collect (dest, source, mark, source->order, true, forward))
+            return false;
+        collect (source, nullptr, mark, dest->order, false, backward);
+
+        OrderSorter sorter;
+        forward.sort (sorter);
+        backward.sort (sorter);
+
+        // Reuse the same order slots, nodes that feed source come first.
+        Array<int> slots;
+        for (auto* entry : backward)    slots.add (entry->order);
+        for (auto* entry : forward)     slots.add (entry->order);
+        slots.sort();
+
+        int slot = 0;
+        for (auto* entry : backward)    entry->order = slots.getUnchecked (slot++);
+        for (auto* entry : forward)     entry->order = slots.getUnchecked (slot++);
+        return true;
+    }
+
+    /** After a removal, see if arcs that closed a cycle can now be ordered */
+    void retryCyclicArcs()
+    {
+        for (int i = cyclicArcs.size(); --i >= 0;)
+        {
+            const CyclicArc arc = cyclicArcs.getUnchecked (i);
+            if (arc.source == arc.dest)
+                continue;
+            if (arc.source->order >= arc.dest->order && ! reorder (arc.source, arc.dest))
+                continue;
+
+            bool exists;
+            arc.source->outputs.getReference (indexOfLink (arc.source->outputs, arc.dest, exists)).cyclic = false;
+            cyclicArcs.remove (i);
+        }
     }
 
     Entry* findEntry (const uint32 destNode, int& insertIndex) const noexcept
@@ -146,7 +517,7 @@ private:
             {
                 break;
             }
-            else if (destNode == entries.getUnchecked (start)->destNode)
+            else if (destNode == entries.getUnchecked (start)->nodeId)
             {
                 result = entries.getUnchecked (start);
                 break;
@@ -157,12 +528,12 @@ private:
 
                 if (halfway == start)
                 {
-                    if (destNode >= entries.getUnchecked (halfway)->destNode)
+                    if (destNode >= entries.getUnchecked (halfway)->nodeId)
                         ++start;
 
                     break;
                 }
-                else if (destNode >= entries.getUnchecked (halfway)->destNode)
+                else if (destNode >= entries.getUnchecked (halfway)->nodeId)
                     start = halfway;
                 else
                     end = halfway;
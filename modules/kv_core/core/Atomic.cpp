@@ -0,0 +1,201 @@
+/*
+    This file is part of the Kushview Modules for JUCE
+    Copyright (c) 2014-2019  Kushview, LLC.  All rights reserved.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+static_assert (sizeof (std::atomic<int32>) == sizeof (int32),
+               "futexes need a plain 32 bit word");
+
+#if ! JUCE_LINUX
+namespace FutexHelpers
+{
+    /** Used where the OS can't park a thread on an address */
+    static bool yieldWhileEqual (std::atomic<int32>& word, int32 expected, int timeoutMs)
+    {
+        const uint32 start = Time::getMillisecondCounter();
+        while (word.load (std::memory_order_acquire) == expected)
+        {
+            if (timeoutMs >= 0 && Time::getMillisecondCounter() - start >= (uint32) timeoutMs)
+                return false;
+            Thread::yield();
+        }
+        return true;
+    }
+}
+#endif
+
+#if JUCE_LINUX
+
+bool Futex::wait (std::atomic<int32>& word, int32 expected, int timeoutMs)
+{
+    struct timespec timeout;
+    if (timeoutMs >= 0)
+    {
+        timeout.tv_sec  = timeoutMs / 1000;
+        timeout.tv_nsec = (timeoutMs % 1000) * 1000000;
+    }
+
+    const long res = syscall (SYS_futex, reinterpret_cast<int32*> (&word), FUTEX_WAIT_PRIVATE,
+                              expected, timeoutMs >= 0 ? &timeout : nullptr, nullptr, 0);
+    return ! (res != 0 && errno == ETIMEDOUT);
+}
+
+void Futex::wake (std::atomic<int32>& word, int32 count)
+{
+    syscall (SYS_futex, reinterpret_cast<int32*> (&word), FUTEX_WAKE_PRIVATE,
+             count, nullptr, nullptr, 0);
+}
+
+#elif JUCE_WINDOWS
+
+namespace FutexHelpers
+{
+    typedef BOOL (WINAPI* WaitOnAddressFn) (volatile VOID*, PVOID, SIZE_T, DWORD);
+    typedef VOID (WINAPI* WakeByAddressFn) (PVOID);
+
+    /** WaitOnAddress needs Windows 8, so look it up rather than link
+        Synchronization.lib and fail to load on older systems */
+    struct WaitOnAddressApi
+    {
+        WaitOnAddressApi()
+        {
+            if (HMODULE dll = LoadLibraryA ("api-ms-win-core-synch-l1-2-0.dll"))
+            {
+                waitOnAddress = (WaitOnAddressFn) GetProcAddress (dll, "WaitOnAddress");
+                wakeSingle    = (WakeByAddressFn) GetProcAddress (dll, "WakeByAddressSingle");
+                wakeAll       = (WakeByAddressFn) GetProcAddress (dll, "WakeByAddressAll");
+            }
+        }
+
+        bool isAvailable() const noexcept { return waitOnAddress != nullptr && wakeSingle != nullptr && wakeAll != nullptr; }
+
+        WaitOnAddressFn waitOnAddress = nullptr;
+        WakeByAddressFn wakeSingle = nullptr, wakeAll = nullptr;
+    };
+
+    static const WaitOnAddressApi& getApi()
+    {
+        static const WaitOnAddressApi api;
+        return api;
+    }
+}
+
+bool Futex::wait (std::atomic<int32>& word, int32 expected, int timeoutMs)
+{
+    const auto& api = FutexHelpers::getApi();
+    if (! api.isAvailable())
+        return FutexHelpers::yieldWhileEqual (word, expected, timeoutMs);
+
+    if (api.waitOnAddress (&word, &expected, sizeof (int32), timeoutMs >= 0 ? (DWORD) timeoutMs : INFINITE))
+        return true;
+    return GetLastError() != ERROR_TIMEOUT;
+}
+
+void Futex::wake (std::atomic<int32>& word, int32 count)
+{
+    const auto& api = FutexHelpers::getApi();
+    if (! api.isAvailable())
+        return;
+
+    if (count == 1)
+        api.wakeSingle (&word);
+    else
+        api.wakeAll (&word);
+}
+
+#elif JUCE_MAC || JUCE_IOS
+
+// The ulock calls are what libc++ uses for std::atomic::wait. They have
+// been in the kernel since 10.12 but have no public header, so declare
+// them weakly and fall back to yielding when they aren't there.
+extern "C" int __ulock_wait (uint32_t operation, void* addr, uint64_t value, uint32_t timeoutMicros) __attribute__((weak_import));
+extern "C" int __ulock_wake (uint32_t operation, void* addr, uint64_t wakeValue) __attribute__((weak_import));
+
+namespace FutexHelpers
+{
+    enum
+    {
+        compareAndWait = 1,             // UL_COMPARE_AND_WAIT
+        wakeAll        = 0x00000100,    // ULF_WAKE_ALL
+        noErrno        = 0x01000000     // ULF_NO_ERRNO
+    };
+}
+
+bool Futex::wait (std::atomic<int32>& word, int32 expected, int timeoutMs)
+{
+    if (__ulock_wait == nullptr)
+        return FutexHelpers::yieldWhileEqual (word, expected, timeoutMs);
+
+    // a zero timeout means forever, so round short waits up to 1us
+    const uint32_t timeoutMicros = timeoutMs < 0 ? 0u
+        : (uint32_t) jlimit<int64> (1, 0xffffffff, (int64) timeoutMs * 1000);
+    const int res = __ulock_wait (FutexHelpers::compareAndWait | FutexHelpers::noErrno,
+                                  &word, (uint64_t) (uint32) expected, timeoutMicros);
+    return res != -ETIMEDOUT;
+}
+
+void Futex::wake (std::atomic<int32>& word, int32 count)
+{
+    if (__ulock_wake == nullptr)
+        return;
+    __ulock_wake (FutexHelpers::compareAndWait | FutexHelpers::noErrno
+                    | (count == 1 ? 0 : FutexHelpers::wakeAll), &word, 0);
+}
+
+#else
+
+bool Futex::wait (std::atomic<int32>& word, int32 expected, int timeoutMs)
+{
+    return FutexHelpers::yieldWhileEqual (word, expected, timeoutMs);
+}
+
+void Futex::wake (std::atomic<int32>&, int32) { }
+
+#endif
+
+/** Tell the cpu we are in a spin loop */
+static inline void spinPause()
+{
+   #if JUCE_INTEL
+    _mm_pause();
+   #elif JUCE_ARM && (JUCE_GCC || JUCE_CLANG)
+    __asm__ __volatile__ ("yield");
+   #endif
+}
+
+void AtomicLock::lockContended()
+{
+    numContended.fetch_add (1, std::memory_order_relaxed);
+
+    // Spin with exponential backoff. Most critical sections shared with the
+    // audio thread are short, so this usually gets the lock without a syscall
+    for (int pauses = 1; pauses <= 1024; pauses <<= 1)
+    {
+        for (int i = 0; i < pauses; ++i)
+            spinPause();
+
+        if (state.load (std::memory_order_relaxed) == 0 && acquire())
+            return;
+    }
+
+    // Mark the lock as having waiters, then sleep until released
+    while (state.exchange (2, std::memory_order_acquire) != 0)
+    {
+        numParked.fetch_add (1, std::memory_order_relaxed);
+        Futex::wait (state, 2);
+    }
+}
@@ -93,46 +93,241 @@ private:
 };
 
 
-class AtomicLock
+/** The sequence counter behind AtomicSnapshot and MonitorBank.
+
+    One writer brackets its stores with beginWrite() and endWrite(), so the
+    count is odd while a write is in progress. A reader takes a ticket with
+    beginRead(), loads the data, then keeps it only if validate() says no
+    write overlapped. The guarded data must be stored and loaded as
+    atomics, with release stores and acquire loads. */
+class SeqLock
 {
 public:
+    SeqLock() : sequence (0) { }
+
+    /** Call before storing the guarded data (writer thread only) */
+    inline void beginWrite() noexcept
+    {
+        // A reader that sees any new word also sees the odd sequence
+        // number stored before it, and so knows to retry.
+        sequence.store (sequence.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    /** Call after storing the guarded data (writer thread only) */
+    inline void endWrite() noexcept
+    {
+        sequence.store (sequence.load (std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /** Start a read (any thread)
+        @returns false if a write is in progress, try again later */
+    inline bool beginRead (uint32& ticket) const noexcept
+    {
+        ticket = sequence.load (std::memory_order_acquire);
+        return (ticket & 1) == 0;
+    }
+
+    /** Returns true if nothing was written since beginRead() gave out ticket */
+    inline bool validate (uint32 ticket) const noexcept
+    {
+        return sequence.load (std::memory_order_relaxed) == ticket;
+    }
+
+    /** Returns the number of completed writes */
+    inline uint32 getVersion() const noexcept { return sequence.load (std::memory_order_acquire) >> 1; }
+
+    /** Returns the number of writes completed before ticket was taken */
+    static inline uint32 versionOf (uint32 ticket) noexcept { return ticket >> 1; }
+
+private:
+    std::atomic<uint32> sequence;
+    JUCE_DECLARE_NON_COPYABLE (SeqLock)
+};
+
+/** Publishes a trivially copyable value from one writer to any number of readers.
+
+    This is a sequence lock. set() is wait-free and never fails, so it is
+    safe to call from the audio thread every cycle. Readers always get a
+    consistent snapshot of the whole value; if they race with a write they
+    retry, which only happens while a write is in progress.
+
+    Use it for transport state, meter blocks and similar structs that
+    several GUI or network threads poll. Only one thread may call set(). */
+template<typename ValueType>
+class AtomicSnapshot
+{
+public:
+    static_assert (std::is_trivially_copyable<ValueType>::value,
+                   "AtomicSnapshot values are copied word by word");
+
+    explicit AtomicSnapshot (const ValueType& initial = ValueType())
+    {
+        for (auto& word : words)
+            word.store (0, std::memory_order_relaxed);
+        set (initial);
+    }
+
+    /** Publish a new value (writer thread only, wait-free) */
+    inline void set (const ValueType& newValue) noexcept
+    {
+        uint64 data [numWords] = { 0 };
+        memcpy (data, &newValue, sizeof (ValueType));
+
+        sequence.beginWrite();
+        for (int i = 0; i < numWords; ++i)
+            words[i].store (data[i], std::memory_order_release);
+        sequence.endWrite();
+    }
+
+    /** Try to read a snapshot without retrying (any thread)
+        @returns false if a write was in progress, in which case value is untouched */
+    inline bool tryGet (ValueType& value) const noexcept
+    {
+        uint32 ticket;
+        if (! sequence.beginRead (ticket))
+            return false;
+
+        uint64 data [numWords];
+        for (int i = 0; i < numWords; ++i)
+            data[i] = words[i].load (std::memory_order_acquire);
+
+        if (! sequence.validate (ticket))
+            return false;
+
+        memcpy (&value, data, sizeof (ValueType));
+        return true;
+    }
+
+    /** Read a consistent snapshot (any thread) */
+    inline ValueType get() const noexcept
+    {
+        ValueType value;
+        while (! tryGet (value))
+            Thread::yield();
+        return value;
+    }
+
+    /** Returns the number of times set() has been called, including the
+        initial value. Readers can compare this to skip unchanged values */
+    inline uint32 getVersion() const noexcept { return sequence.getVersion(); }
 
-    AtomicLock()
-        : a_mutex(),
-          a_locks(0)
-    { }
+private:
+    enum { numWords = (sizeof (ValueType) + sizeof (uint64) - 1) / sizeof (uint64) };
+    SeqLock sequence;
+    std::atomic<uint64> words [numWords];
+
+    JUCE_DECLARE_NON_COPYABLE (AtomicSnapshot)
+};
+
+/** @internal Parks threads on a 32 bit word.
+    Waiters sleep in the kernel using a futex on Linux, WaitOnAddress on
+    Windows 8+ and __ulock_wait on macOS/iOS 10.12+. Older systems and
+    other platforms fall back to yielding until the word changes. */
+struct Futex
+{
+    /** Sleep while word == expected, or until the timeout passes.
+        May return spuriously, so always re-check the word.
+        @param timeoutMs Milliseconds to wait, or -1 to wait forever
+        @returns false if the timeout expired */
+    static bool wait (std::atomic<int32>& word, int32 expected, int timeoutMs = -1);
 
+    /** Wake up to count threads waiting on word */
+    static void wake (std::atomic<int32>& word, int32 count);
+};
+
+/** A lock for sharing data with a realtime thread.
+
+    acquire() is a non-blocking try-lock and is realtime safe. lock() spins
+    for a short while with exponential backoff, then parks the thread until
+    the holder releases it, so waiting threads don't burn whole cores under
+    contention. lock()/unlock() are recursive for the locking thread.
+
+    Contention counters can be read at any time for diagnostics. */
+class AtomicLock
+{
+public:
+    AtomicLock() : state (0), owner (nullptr), recursion (0) { }
+
+    /** Try to take the lock without blocking. Realtime safe.
+        This is not recursive, pair it with release() */
     inline bool acquire()
     {
-        return ! a_mutex.test_and_set (std::memory_order_acquire);
+        int32 expected = 0;
+        return state.compare_exchange_strong (expected, 1, std::memory_order_acquire,
+                                                          std::memory_order_relaxed);
     }
 
+    /** Release a lock taken with acquire() */
     inline void release()
     {
-        a_mutex.clear (std::memory_order_release);
+        if (state.exchange (0, std::memory_order_release) == 2)
+            Futex::wake (state, 1);
     }
 
+    /** Take the lock, blocking if needed */
     inline void lock()
     {
-        a_locks.set (a_locks.get() + 1);
-        if (a_locks.get() == 1)
-            while (! acquire())
-                ; // spin
+        const Thread::ThreadID self = Thread::getCurrentThreadId();
+        if (owner.load (std::memory_order_relaxed) == self)
+        {
+            ++recursion;
+            return;
+        }
+
+        numLocks.fetch_add (1, std::memory_order_relaxed);
+        if (! acquire())
+            lockContended();
+
+        owner.store (self, std::memory_order_relaxed);
+        recursion = 1;
     }
 
+    /** Release the lock taken by lock() */
     inline void unlock()
     {
-        a_locks.set (a_locks.get() - 1);
-        if (a_locks.get() < 1)
-        {
-            a_locks.set(0);
-            release();
-        }
+        jassert (owner.load (std::memory_order_relaxed) == Thread::getCurrentThreadId());
+        if (--recursion > 0)
+            return;
+
+        owner.store (nullptr, std::memory_order_relaxed);
+        release();
+    }
+
+    inline bool isBusy() const { return state.load (std::memory_order_relaxed) != 0; }
+
+    /** Contention counters */
+    struct Stats
+    {
+        uint64 locks;       ///< calls to lock() which weren't recursive
+        uint64 contended;   ///< locks which had to spin
+        uint64 parked;      ///< times a thread went to sleep waiting
+    };
+
+    /** Returns the contention counters. Approximate while the lock is in use */
+    inline Stats getStats() const
+    {
+        Stats stats;
+        stats.locks     = numLocks.load (std::memory_order_relaxed);
+        stats.contended = numContended.load (std::memory_order_relaxed);
+        stats.parked    = numParked.load (std::memory_order_relaxed);
+        return stats;
     }
 
-    inline bool isBusy() const { return a_locks.get() > 0; }
+    /** Zero the contention counters */
+    inline void resetStats()
+    {
+        numLocks = numContended = numParked = 0;
+    }
 
 private:
-    std::atomic_flag    a_mutex;
-    AtomicValue<int>    a_locks;
+    /** 0 = unlocked, 1 = locked, 2 = locked and a thread may be parked */
+    std::atomic<int32> state;
+    std::atomic<Thread::ThreadID> owner;
+    int recursion;
+
+    std::atomic<uint64> numLocks { 0 }, numContended { 0 }, numParked { 0 };
+
+    void lockContended();
+
+    JUCE_DECLARE_NON_COPYABLE (AtomicLock)
 };
@@ -101,6 +101,48 @@ public:
         finishedWrite (size1 + size2);
     }
 
+    /*< Push interleaved frames into the FIFO, deinterleaving them on the way in.
+        The source must have the same number of channels as this FIFO */
+    void writeInterleaved (const FloatType* frames, int numFrames)
+    {
+        writeInterleavedInternal (frames, numFrames, FloatType (1));
+    }
+
+    /*< Push interleaved 16 bit integer frames, converting to floating point */
+    void writeInterleaved (const juce::int16* frames, int numFrames)
+    {
+        writeInterleavedInternal (frames, numFrames, FloatType (1.0 / 0x8000));
+    }
+
+    /*< Push interleaved 32 bit integer frames, converting to floating point */
+    void writeInterleaved (const juce::int32* frames, int numFrames)
+    {
+        writeInterleavedInternal (frames, numFrames, FloatType (1.0 / 0x80000000));
+    }
+
+    /*< Read samples from the FIFO into an interleaved buffer */
+    void readInterleaved (FloatType* frames, int numFrames)
+    {
+        jassert (getNumReady() >= numFrames);
+        const int numChannels = buffer.getNumChannels();
+        int start1, size1, start2, size2;
+        prepareToRead (numFrames, start1, size1, start2, size2);
+        if (numChannels == 2)
+        {
+            interleaveStereo (buffer.getReadPointer (0, start1), buffer.getReadPointer (1, start1), frames, size1);
+            interleaveStereo (buffer.getReadPointer (0, start2), buffer.getReadPointer (1, start2), frames + (size1 * 2), size2);
+        }
+        else
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                interleave (buffer.getReadPointer (channel, start1), frames + channel, numChannels, size1);
+                interleave (buffer.getReadPointer (channel, start2), frames + (size1 * numChannels) + channel, numChannels, size2);
+            }
+        }
+        finishedRead (size1 + size2);
+    }
+
     /*< Read samples from the FIFO into raw float arrays */
     void readFromFifo (FloatType** samples, int numSamples)
     {
@@ -168,4 +210,81 @@ public:
 private:
     /*< The actual audio buffer */
     juce::AudioBuffer<FloatType> buffer;
+
+    /*< Converts and deinterleaves straight into the ring. Stereo splits
+        both channels in one loop with a constant stride, which GCC
+        vectorizes at -O3. Mono float is a plain copy. Other channel counts
+        use a scalar strided loop per channel. */
+    template<typename SampleType>
+    void writeInterleavedInternal (const SampleType* frames, int numFrames, const FloatType scale)
+    {
+        jassert (getFreeSpace() >= numFrames);
+        const int numChannels = buffer.getNumChannels();
+        int start1, size1, start2, size2;
+        prepareToWrite (numFrames, start1, size1, start2, size2);
+        if (numChannels == 2)
+        {
+            deinterleaveStereo (frames, buffer.getWritePointer (0, start1), buffer.getWritePointer (1, start1), size1, scale);
+            deinterleaveStereo (frames + (size1 * 2), buffer.getWritePointer (0, start2), buffer.getWritePointer (1, start2), size2, scale);
+        }
+        else
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                deinterleave (frames + channel, numChannels, buffer.getWritePointer (channel, start1), size1, scale);
+                deinterleave (frames + (size1 * numChannels) + channel, numChannels, buffer.getWritePointer (channel, start2), size2, scale);
+            }
+        }
+        finishedWrite (size1 + size2);
+    }
+
+    template<typename SampleType>
+    static void deinterleaveStereo (const SampleType* src, FloatType* left, FloatType* right, int numSamples, const FloatType scale)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            left[i]  = static_cast<FloatType> (src[2 * i]) * scale;
+            right[i] = static_cast<FloatType> (src[2 * i + 1]) * scale;
+        }
+    }
+
+    static void interleaveStereo (const FloatType* left, const FloatType* right, FloatType* dest, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            dest[2 * i]     = left[i];
+            dest[2 * i + 1] = right[i];
+        }
+    }
+
+    static void deinterleave (const FloatType* src, int stride, FloatType* dest, int numSamples, FloatType)
+    {
+        if (stride == 1)
+        {
+            juce::FloatVectorOperations::copy (dest, src, numSamples);
+            return;
+        }
+
+        for (int i = 0; i < numSamples; ++i)
+            dest[i] = src[i * stride];
+    }
+
+    template<typename IntType>
+    static void deinterleave (const IntType* src, int stride, FloatType* dest, int numSamples, const FloatType scale)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            dest[i] = static_cast<FloatType> (src[i * stride]) * scale;
+    }
+
+    static void interleave (const FloatType* src, FloatType* dest, int stride, int numSamples)
+    {
+        if (stride == 1)
+        {
+            juce::FloatVectorOperations::copy (dest, src, numSamples);
+            return;
+        }
+
+        for (int i = 0; i < numSamples; ++i)
+            dest[i * stride] = src[i];
+    }
 };
@@ -0,0 +1,170 @@
+/*
+    This file is part of the Kushview Modules for JUCE
+    Copyright (c) 2014-2019  Kushview, LLC.  All rights reserved.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+Array<uint32> GraphCompiler::getWave (int wave) const
+{
+    const Range<int> range (getWaveRange (wave));
+    Array<uint32> result;
+    result.ensureStorageAllocated (range.getLength());
+    for (int i = range.getStart(); i < range.getEnd(); ++i)
+        result.add (order.getUnchecked (i));
+    return result;
+}
+
+int GraphCompiler::getWaveOf (uint32 node) const noexcept
+{
+    const int index = nodes.indexOf (node);
+    return index >= 0 ? nodeWaves.getUnchecked (index) : -1;
+}
+
+void GraphCompiler::compile (const ArcList& arcs, const Array<uint32>& extraNodes)
+{
+    order.clearQuick();
+    waveStarts.clearQuick();
+    nodes.clearQuick();
+    nodeWaves.clearQuick();
+    delayArcs.clear();
+
+    for (const ArcData& arc : arcs)
+    {
+        nodes.add (arc.sourceNode);
+        nodes.add (arc.destNode);
+    }
+    for (const uint32 node : extraNodes)
+        nodes.add (node);
+
+    const int numNodes = nodes.size();
+    if (numNodes == 0)
+        return;
+
+    // Arcs are sorted by source then destination, so parallel arcs between
+    // two nodes collapse into one link and links are grouped by source.
+    Array<int> firstLink, linkDest, arcLink;
+    firstLink.insertMultiple (0, 0, numNodes + 1);
+    int lastSource = -1, lastDest = -1;
+    for (const ArcData& arc : arcs)
+    {
+        const int source = nodes.indexOf (arc.sourceNode);
+        const int dest   = nodes.indexOf (arc.destNode);
+        if (source != lastSource || dest != lastDest)
+        {
+            linkDest.add (dest);
+            ++firstLink.getReference (source + 1);
+            lastSource = source;
+            lastDest   = dest;
+        }
+        arcLink.add (linkDest.size() - 1);
+    }
+
+    for (int i = 0; i < numNodes; ++i)
+        firstLink.getReference (i + 1) += firstLink.getUnchecked (i);
+
+    // Depth first search, links back to a node still on the stack close a
+    // feedback loop. Dropping just those leaves the graph acyclic.
+    enum { unvisited = 0, onStack, done };
+    Array<int> state, stackNodes, stackLinks;
+    Array<bool> delayed;
+    state.insertMultiple (0, unvisited, numNodes);
+    delayed.insertMultiple (0, false, linkDest.size());
+
+    for (int root = 0; root < numNodes; ++root)
+    {
+        if (state.getUnchecked (root) != unvisited)
+            continue;
+
+        state.set (root, onStack);
+        stackNodes.add (root);
+        stackLinks.add (firstLink.getUnchecked (root));
+
+        while (stackNodes.size() > 0)
+        {
+            const int node = stackNodes.getLast();
+            const int link = stackLinks.getLast();
+            if (link >= firstLink.getUnchecked (node + 1))
+            {
+                state.set (node, done);
+                stackNodes.removeLast();
+                stackLinks.removeLast();
+                continue;
+            }
+
+            stackLinks.set (stackLinks.size() - 1, link + 1);
+            const int dest = linkDest.getUnchecked (link);
+            if (state.getUnchecked (dest) == onStack)
+            {
+                delayed.set (link, true);
+            }
+            else if (state.getUnchecked (dest) == unvisited)
+            {
+                state.set (dest, onStack);
+                stackNodes.add (dest);
+                stackLinks.add (firstLink.getUnchecked (dest));
+            }
+        }
+    }
+
+    // Kahn's algorithm. A node's wave is the longest chain of links leading
+    // to it, so everything it depends on is in an earlier wave.
+    Array<int> numInputs, ready;
+    numInputs.insertMultiple (0, 0, numNodes);
+    nodeWaves.insertMultiple (0, 0, numNodes);
+    for (int link = 0; link < linkDest.size(); ++link)
+        if (! delayed.getUnchecked (link))
+            ++numInputs.getReference (linkDest.getUnchecked (link));
+
+    for (int node = 0; node < numNodes; ++node)
+        if (numInputs.getUnchecked (node) == 0)
+            ready.add (node);
+
+    int numWaves = 1;
+    for (int next = 0; next < ready.size(); ++next)
+    {
+        const int node = ready.getUnchecked (next);
+        const int wave = nodeWaves.getUnchecked (node);
+        for (int link = firstLink.getUnchecked (node); link < firstLink.getUnchecked (node + 1); ++link)
+        {
+            if (delayed.getUnchecked (link))
+                continue;
+
+            const int dest = linkDest.getUnchecked (link);
+            nodeWaves.set (dest, jmax (nodeWaves.getUnchecked (dest), wave + 1));
+            numWaves = jmax (numWaves, wave + 2);
+            if (--numInputs.getReference (dest) == 0)
+                ready.add (dest);
+        }
+    }
+
+    jassert (ready.size() == numNodes);
+
+    // Bucket nodes by wave, keeping them sorted by id within a wave
+    waveStarts.insertMultiple (0, 0, numWaves + 1);
+    for (int node = 0; node < numNodes; ++node)
+        ++waveStarts.getReference (nodeWaves.getUnchecked (node) + 1);
+    for (int wave = 0; wave < numWaves; ++wave)
+        waveStarts.getReference (wave + 1) += waveStarts.getUnchecked (wave);
+
+    Array<int> slots (waveStarts);
+    order.insertMultiple (0, 0, numNodes);
+    for (int node = 0; node < numNodes; ++node)
+        order.set (slots.getReference (nodeWaves.getUnchecked (node))++, nodes.getUnchecked (node));
+
+    for (int i = 0; i < arcs.size(); ++i)
+        if (delayed.getUnchecked (arcLink.getUnchecked (i)))
+            delayArcs.add (arcs.getUnchecked (i));
+}
@@ -0,0 +1,91 @@
+/*
+    This file is part of the Kushview Modules for JUCE
+    Copyright (c) 2014-2019  Kushview, LLC.  All rights reserved.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#pragma once
+
+/** Turns a set of arcs into an execution order for a processing graph.
+
+    Nodes are put in topological order and grouped into waves. No node in a
+    wave depends on another node of the same wave, so a host can process a
+    whole wave in parallel, as long as each wave finishes before the next
+    one starts.
+
+    Feedback loops are broken by picking arcs which become delay arcs. A
+    delay arc carries data into the next block instead of the current one,
+    so the rest of the graph can be ordered. */
+class JUCE_API GraphCompiler
+{
+public:
+    GraphCompiler() { }
+    ~GraphCompiler() { }
+
+    /** Compile a set of arcs, replacing the previous result.
+        @param arcs         The arcs to schedule
+        @param extraNodes   Nodes without any arcs that should be scheduled too */
+    template<class ArcType>
+    void compile (const OwnedArray<ArcType>& arcs, const Array<uint32>& extraNodes = Array<uint32>())
+    {
+        compile (ArcList (arcs), extraNodes);
+    }
+
+    /** Compile a list of arcs, replacing the previous result. */
+    void compile (const ArcList& arcs, const Array<uint32>& extraNodes = Array<uint32>());
+
+    /** Returns every node in topological order, wave by wave */
+    const Array<uint32>& getOrder() const noexcept { return order; }
+
+    /** Returns the number of waves */
+    int getNumWaves() const noexcept { return jmax (0, waveStarts.size() - 1); }
+
+    /** Returns the range of getOrder() indexes that make up a wave */
+    Range<int> getWaveRange (int wave) const noexcept
+    {
+        return isPositiveAndBelow (wave, getNumWaves())
+            ? Range<int> (waveStarts.getUnchecked (wave), waveStarts.getUnchecked (wave + 1))
+            : Range<int>();
+    }
+
+    /** Returns the nodes in a wave, these can be processed in parallel */
+    Array<uint32> getWave (int wave) const;
+
+    /** Returns the wave a node belongs to, or -1 if it isn't in the graph */
+    int getWaveOf (uint32 node) const noexcept;
+
+    /** Returns the arcs that were turned into delays to break feedback loops */
+    const ArcList& getDelayArcs() const noexcept { return delayArcs; }
+
+    /** Returns true if the graph had at least one feedback loop */
+    bool hasFeedback() const noexcept { return delayArcs.size() > 0; }
+
+    /** Returns true if an arc was turned into a delay */
+    bool isDelayArc (uint32 sourceNode, uint32 sourcePort, uint32 destNode, uint32 destPort) const noexcept
+    {
+        const ArcData arc = { sourceNode, sourcePort, destNode, destPort };
+        return delayArcs.contains (arc);
+    }
+
+private:
+    Array<uint32> order;
+    Array<int> waveStarts;      ///< order index of each wave, plus one past the end
+    SortedSet<uint32> nodes;
+    Array<int> nodeWaves;       ///< wave of each node, indexed like nodes
+    ArcList delayArcs;
+
+    JUCE_DECLARE_NON_COPYABLE (GraphCompiler)
+};
@@ -21,12 +21,23 @@
 
 #pragma once
 
-/** A doubly linked list */
+/** A doubly linked list
+
+    A scoped list owns its nodes. Removed nodes are kept on a free list and
+    handed back out by create(), so a list that is edited often stops
+    touching the heap once it has grown to its working size.
+
+    With the index cache enabled, at() and find() remember the last position
+    they resolved and walk from there, so scanning the list in order is linear
+    overall instead of quadratic. Only the non-const at() and find() write
+    the cache; the const versions just read it, so const lookups may run
+    on several threads at once as long as nothing modifies the list. */
 template <class Node>
 class LinkedList
 {
 public:
-    LinkedList() : firstNode(0), lastNode(0), numNodes(0), freeList(0), scopedList(false) { }
+    LinkedList() : firstNode(0), lastNode(0), numNodes(0), freeList(0), numFree(0),
+                   scopedList(false), indexCached(false), cachedNode(0), cachedIndex(0) { }
     ~LinkedList() { clear(); }
 
     Node* first() const { return firstNode; }
@@ -42,11 +53,55 @@ public:
     void unlink (Node *node);
     void remove (Node *node);
     void clear();
-    Node* at (int index) const;
+
+    /** Remove all nodes, keeping them on the free list of a scoped list */
+    void removeAll();
+
+    /** Construct a node, reusing one from the free list if available.
+        The node still needs inserting. */
+    template <typename... Args>
+    Node* create (Args&&... args);
+
+    /** Fill the free list until at least numToReserve are available.
+        Nodes are constructed with the given arguments. Scoped lists only. */
+    template <typename... Args>
+    void reserve (int numToReserve, Args&&... args);
+
+    /** Returns the number of nodes waiting on the free list */
+    int getNumFree() const { return numFree; }
+
+    /** Enable or disable the at()/find() position cache */
+    void setIndexCached (bool cached) { indexCached = cached; cachedNode = 0; }
+    bool isIndexCached() const { return indexCached; }
+
+    /** Returns the node at an index, walking from the closest of the
+        first, last or cached node. The non-const versions of at() and
+        find() move the cache. The const versions only read it, so const
+        lookups from several threads don't race each other */
+    Node* at (int index)
+    {
+        Node* const node = locate (index);
+        if (node)
+            cache (node, index);
+        return node;
+    }
+
+    Node* at (int index) const { return locate (index); }
+
     void prepend (Node *node) { insertBefore (node); }
     void append (Node *node)  { insertAfter (node); }
     Node *operator[] (int index) const { return at(index); }
-    int find (Node *node) const;
+
+    /** Returns the index of a node, or -1 */
+    int find (Node *node)
+    {
+        const int index = indexOf (node);
+        if (index >= 0)
+            cache (node, index);
+        return index;
+    }
+
+    int find (Node *node) const { return indexOf (node); }
 
     /** Base list node */
     class Link
@@ -120,7 +175,23 @@ private:
     Node *lastNode;
     int numNodes;
     Node *freeList;
+    int numFree;
     bool scopedList;
+    bool indexCached;
+    Node *cachedNode;
+    int cachedIndex;
+
+    Node* locate (int index) const;
+    int indexOf (Node *node) const;
+
+    void cache (Node *node, int index)
+    {
+        if (indexCached)
+        {
+            cachedNode  = node;
+            cachedIndex = index;
+        }
+    }
 };
 
 template <class Node> 
@@ -146,6 +217,7 @@ void LinkedList<Node>::insertAfter (Node *node, Node *previous)
     }
 
     ++numNodes;
+    cachedNode = 0;
 }
 
 template <class Node>
@@ -172,6 +244,7 @@ void LinkedList<Node>::insertBefore (Node *node, Node *next_node)
     }
 
     ++numNodes;
+    cachedNode = 0;
 }
 
 template <class Node>
@@ -188,6 +261,7 @@ void LinkedList<Node>::unlink (Node *node)
         lastNode = node->prev();
 
     --numNodes;
+    cachedNode = 0;
 }
 
 // Remove method.
@@ -202,6 +276,7 @@ void LinkedList<Node>::remove (Node *node)
         Node *nextFree = freeList;
         node->setNextFree (nextFree);
         freeList = node;
+        ++numFree;
     }
 }
 
@@ -229,10 +304,56 @@ void LinkedList<Node>::clear()
     firstNode = lastNode = 0;
     numNodes = 0;
     freeList = 0;
+    numFree = 0;
+    cachedNode = 0;
 }
 
 template <class Node>
-Node* LinkedList<Node>::at (int index) const
+void LinkedList<Node>::removeAll()
+{
+    Node *last = lastNode;
+    while (last)
+    {
+        remove (last);
+        last = lastNode;
+    }
+}
+
+template <class Node>
+template <typename... Args>
+Node* LinkedList<Node>::create (Args&&... args)
+{
+    Node *node = freeList;
+    if (node == 0)
+        return new Node (std::forward<Args> (args)...);
+
+    freeList = node->nextFree();
+    --numFree;
+
+    // Rebuild in place, the memory stays with the list.
+    node->~Node();
+    return new (node) Node (std::forward<Args> (args)...);
+}
+
+template <class Node>
+template <typename... Args>
+void LinkedList<Node>::reserve (int numToReserve, Args&&... args)
+{
+    jassert (scopedList);
+    if (! scopedList)
+        return;
+
+    while (numFree < numToReserve)
+    {
+        Node *node = new Node (args...);
+        node->setNextFree (freeList);
+        freeList = node;
+        ++numFree;
+    }
+}
+
+template <class Node>
+Node* LinkedList<Node>::locate (int index) const
 {
     int i;
     Node *node;
@@ -240,7 +361,17 @@ Node* LinkedList<Node>::at (int index) const
     if (index < 0 || index >= numNodes)
       return 0;
 
-    if (index > (numNodes >> 1))
+    // Walk from whichever of first, last or the cached node is closest.
+    const int fromCache = cachedNode ? std::abs (index - cachedIndex) : numNodes;
+    if (fromCache < index && fromCache < numNodes - 1 - index)
+    {
+        node = cachedNode;
+        for (i = cachedIndex; node && i < index; ++i, node = node->next())
+        { ; }
+        for (; node && i > index; --i, node = node->prev())
+        { ; }
+    }
+    else if (index > (numNodes >> 1))
     {
         for (i = numNodes - 1, node = lastNode; node && i > index; --i, node = node->prev())
         { ; }
@@ -255,8 +386,30 @@ Node* LinkedList<Node>::at (int index) const
 }
 
 template <class Node>
-int LinkedList<Node>::find (Node *node) const
+int LinkedList<Node>::indexOf (Node *node) const
 {
+    if (node == 0)
+        return -1;
+
+    if (cachedNode)
+    {
+        // Search outwards from the cached node, nearby nodes are found first.
+        Node *fwd = cachedNode, *back = cachedNode->prev();
+        int offset = 0;
+        while (fwd || back)
+        {
+            if (fwd == node || back == node)
+                return fwd == node ? cachedIndex + offset
+                                   : cachedIndex - offset - 1;
+
+            fwd  = fwd  ? fwd->next()  : 0;
+            back = back ? back->prev() : 0;
+            ++offset;
+        }
+
+        return -1;
+    }
+
     int index = 0;
     Node *n = firstNode;
 
@@ -267,7 +420,7 @@ int LinkedList<Node>::find (Node *node) const
 
         n = n->next();
         ++index;
-  }
+    }
 
-  return -1;
+    return -1;
 }
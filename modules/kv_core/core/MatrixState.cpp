@@ -19,32 +19,301 @@
 
 void MatrixState::setFrom (const MatrixState& o)
 {
-    for (int row = jmin (getNumRows(), o.getNumRows()); --row >= 0;)
-        for (int col = jmin (getNumColumns(), o.getNumColumns()); --col >= 0;)
-            set (row, col, o.connected (row, col));
+    const int rows    = jmin (getNumRows(), o.getNumRows());
+    const int columns = jmin (getNumColumns(), o.getNumColumns());
+    if (columns <= 0)
+        return;
+
+    // whole words first, then the bits of the last shared word
+    const int fullWords = columns >> 6;
+    const uint64 tailMask = (columns & 63) == 0 ? 0 : (((uint64) 1 << (columns & 63)) - 1);
+
+    for (int row = 0; row < rows; ++row)
+    {
+        uint64* const dst       = words.getRawDataPointer() + row * wordsPerRow;
+        const uint64* const src = o.words.begin() + row * o.wordsPerRow;
+        for (int w = 0; w < fullWords; ++w)
+            dst[w] = src[w];
+        if (tailMask != 0)
+            dst[fullWords] = (dst[fullWords] & ~tailMask) | (src[fullWords] & tailMask);
+    }
 }
 
 void MatrixState::resize (int r, int c, bool retain)
 {
     if (r < 0) r = 0;
     if (c < 0) c = 0;
-    
-    BigInteger bits;
-    bits.setRange (0, r * c, false);
-    
-    // TODO: retain set bits
+
+    const MatrixState old (retain ? *this : MatrixState());
+
+    numRows     = r;
+    numColumns  = c;
+    wordsPerRow = (c + 63) >> 6;
+    words.clearQuick();
+    words.insertMultiple (0, 0, numRows * wordsPerRow);
+
     if (retain)
-    {
-        const auto old = *this;
-        numRows = r; 
-        numColumns = c;
-        toggled.swapWith (bits);
         setFrom (old);
+}
+
+void MatrixState::setRow (int row, bool on)
+{
+    if (! isPositiveAndBelow (row, numRows) || wordsPerRow <= 0)
+        return;
+
+    uint64* const data = words.getRawDataPointer() + row * wordsPerRow;
+    for (int w = 0; w < wordsPerRow; ++w)
+        data[w] = on ? ~(uint64) 0 : 0;
+    data[wordsPerRow - 1] &= lastWordMask();
+}
+
+void MatrixState::setColumn (int column, bool on)
+{
+    if (! isPositiveAndBelow (column, numColumns))
+        return;
+
+    const uint64 bit = bitFor (column);
+    uint64* data = words.getRawDataPointer() + (column >> 6);
+    for (int row = 0; row < numRows; ++row, data += wordsPerRow)
+        *data = on ? (*data | bit) : (*data & ~bit);
+}
+
+void MatrixState::clear()
+{
+    words.fill (0);
+}
+
+void MatrixState::copyRow (int sourceRow, int destRow)
+{
+    if (! isPositiveAndBelow (sourceRow, numRows) || ! isPositiveAndBelow (destRow, numRows) || sourceRow == destRow)
+        return;
+
+    uint64* const data = words.getRawDataPointer();
+    memcpy (data + destRow * wordsPerRow, data + sourceRow * wordsPerRow, sizeof (uint64) * (size_t) wordsPerRow);
+}
+
+void MatrixState::copyColumn (int sourceColumn, int destColumn)
+{
+    if (! isPositiveAndBelow (sourceColumn, numColumns) || ! isPositiveAndBelow (destColumn, numColumns))
+        return;
+
+    const int srcWord = sourceColumn >> 6, dstWord = destColumn >> 6;
+    const int srcShift = sourceColumn & 63, dstShift = destColumn & 63;
+    uint64* row = words.getRawDataPointer();
+    for (int r = 0; r < numRows; ++r, row += wordsPerRow)
+    {
+        const uint64 bit = (row[srcWord] >> srcShift) & 1;
+        row[dstWord] = (row[dstWord] & ~((uint64) 1 << dstShift)) | (bit << dstShift);
+    }
+}
+
+bool MatrixState::isRowEmpty (int row) const
+{
+    if (! isPositiveAndBelow (row, numRows))
+        return true;
+
+    const uint64* const data = words.begin() + row * wordsPerRow;
+    for (int w = 0; w < wordsPerRow; ++w)
+        if (data[w] != 0)
+            return false;
+    return true;
+}
+
+int MatrixState::getNumConnected() const
+{
+    int count = 0;
+    for (const uint64 word : words)
+        count += countNumberOfBits (word);
+    return count;
+}
+
+namespace MatrixStateHelpers
+{
+    /** Index of the lowest set bit, word must not be zero */
+    inline int findLowestSetBit (uint64 word)
+    {
+       #if JUCE_GCC || JUCE_CLANG
+        return __builtin_ctzll (word);
+       #else
+        int bit = 0;
+        while ((word & 1) == 0)
+        {
+            word >>= 1;
+            ++bit;
+        }
+        return bit;
+       #endif
+    }
+
+    inline void writeVarInt (MemoryOutputStream& out, uint32 value)
+    {
+        while (value >= 0x80)
+        {
+            out.writeByte ((char) (0x80 | (value & 0x7f)));
+            value >>= 7;
+        }
+        out.writeByte ((char) value);
+    }
+
+    inline bool readVarInt (const uint8*& data, const uint8* end, uint32& value)
+    {
+        value = 0;
+        for (int shift = 0; data < end && shift < 35; shift += 7)
+        {
+            const uint8 byte = *data++;
+            value |= (uint32) (byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+        return false;
+    }
+}
+
+int MatrixState::findNextConnected (int row, int startColumn) const
+{
+    if (! isPositiveAndBelow (row, numRows) || startColumn >= numColumns)
+        return -1;
+    if (startColumn < 0)
+        startColumn = 0;
+
+    const uint64* const data = words.begin() + row * wordsPerRow;
+    int w = startColumn >> 6;
+    uint64 word = data[w] & (~(uint64) 0 << (startColumn & 63));
+
+    for (;;)
+    {
+        if (word != 0)
+            return (w << 6) + MatrixStateHelpers::findLowestSetBit (word);
+        if (++w >= wordsPerRow)
+            return -1;
+        word = data[w];
+    }
+}
+
+MemoryBlock MatrixState::encodeCells (bool runLength) const
+{
+    MemoryOutputStream out;
+
+    if (runLength)
+    {
+        // Alternating runs of off and on cells, starting with off. Each run
+        // is found a word at a time, so empty stretches are skipped quickly.
+        bool on = false;
+        uint32 run = 0;
+        for (int r = 0; r < numRows; ++r)
+        {
+            const uint64* const row = words.begin() + r * wordsPerRow;
+            for (int c = 0; c < numColumns;)
+            {
+                const uint64 word = on ? ~row[c >> 6] : row[c >> 6];
+                const uint64 rest = word >> (c & 63);
+                const int wordEnd = jmin (numColumns, (c | 63) + 1);
+
+                // length of the current run within this word
+                const int length = rest == 0 ? wordEnd - c
+                                             : jmin (wordEnd - c, MatrixStateHelpers::findLowestSetBit (rest));
+                run += (uint32) length;
+                c += length;
+
+                if (c < wordEnd)
+                {
+                    MatrixStateHelpers::writeVarInt (out, run);
+                    run = 0;
+                    on = ! on;
+                }
+            }
+        }
+
+        if (on)
+            MatrixStateHelpers::writeVarInt (out, run);
     }
     else
     {
-        numRows = r; 
-        numColumns = c;
-        toggled.swapWith (bits);
+        uint8 byte = 0;
+        int numBits = 0;
+        for (int r = 0; r < numRows; ++r)
+        {
+            for (int c = 0; c < numColumns; ++c)
+            {
+                if (connected (r, c))
+                    byte |= (uint8) (1 << numBits);
+                if (++numBits == 8)
+                {
+                    out.writeByte ((char) byte);
+                    byte = 0;
+                    numBits = 0;
+                }
+            }
+        }
+
+        if (numBits > 0)
+            out.writeByte ((char) byte);
     }
+
+    return out.getMemoryBlock();
+}
+
+bool MatrixState::decodeCells (const void* data, size_t size, bool runLength)
+{
+    clear();
+    const uint8* bytes = static_cast<const uint8*> (data);
+    const uint8* const end = bytes + size;
+    const int64 numCells = (int64) numRows * numColumns;
+
+    if (runLength)
+    {
+        int64 cell = 0;
+        bool on = false;
+        uint32 run = 0;
+        while (bytes < end)
+        {
+            if (! MatrixStateHelpers::readVarInt (bytes, end, run) || cell + run > numCells)
+                return false;
+
+            if (on)
+                for (int64 i = cell; i < cell + run; ++i)
+                    connect ((int) (i / numColumns), (int) (i % numColumns));
+
+            cell += run;
+            on = ! on;
+        }
+
+        return true;
+    }
+
+    if ((int64) size * 8 < numCells)
+        return false;
+
+    for (int64 i = 0; i < numCells; ++i)
+        if ((bytes[i >> 3] >> (i & 7)) & 1)
+            connect ((int) (i / numColumns), (int) (i % numColumns));
+    return true;
+}
+
+void RealtimeMatrixState::publish (const MatrixState& matrix)
+{
+    Snapshot& snapshot = buffers [back];
+    snapshot.state = matrix;
+    snapshot.connections.clearQuick();
+    snapshot.rowStarts.clearQuick();
+    snapshot.connections.ensureStorageAllocated (matrix.getNumConnected());
+    snapshot.rowStarts.ensureStorageAllocated (matrix.getNumRows() + 1);
+
+    for (int row = 0; row < matrix.getNumRows(); ++row)
+    {
+        snapshot.rowStarts.add (snapshot.connections.size());
+        for (int column = matrix.findNextConnected (row, 0); column >= 0;
+             column = matrix.findNextConnected (row, column + 1))
+        {
+            const Connection connection = { row, column };
+            snapshot.connections.add (connection);
+        }
+    }
+
+    snapshot.rowStarts.add (snapshot.connections.size());
+    snapshot.version = ++lastVersion;
+
+    // release publishes the filled buffer, acquire takes back one the reader
+    // has finished with
+    back = middle.exchange (back | newFlag, std::memory_order_acq_rel) & indexMask;
 }
@@ -19,29 +19,33 @@
 
 #pragma once
 
+/** A grid of on/off cells, such as a routing matrix.
+
+    Cells are packed into 64 bit words with each row starting on a new word,
+    so whole rows can be set, cleared or copied a word at a time. Unused bits
+    at the end of a row are always zero. */
 class MatrixState
 {
 public:
     MatrixState()
     {
-        numRows = numColumns = 0;
+        numRows = numColumns = wordsPerRow = 0;
     }
 
     MatrixState (const int rows, const int cols)
     {
-        numRows = rows;
-        numColumns = cols;
+        numRows = numColumns = wordsPerRow = 0;
         jassert (rows >= 0 && cols >= 0);
-        toggled.setRange (0, numRows * numColumns, false);
+        resize (rows, cols);
     }
 
     virtual ~MatrixState() { }
     
     inline const bool isEmpty() const { return numRows <= 0 && numColumns <= 0; }
     inline const bool isNotEmpty() const { return !isEmpty(); }
-    inline const bool isValid (int row, int column)
+    inline const bool isValid (int row, int column) const
     {
-        return isPositiveAndBelow (row, numRows) ||
+        return isPositiveAndBelow (row, numRows) &&
                isPositiveAndBelow (column, numColumns);
     }
     
@@ -51,18 +55,16 @@ public:
    
     inline void connect (int row, int column)
     {
-        if (isValid (row, column)) {
-            const int index = getIndexForCell (row, column);
-            toggled.setBit (index, true);
-        }
+        if (isValid (row, column))
+            wordFor (row, column) |= bitFor (column);
     }
     
     inline void set (int r, int c, bool on)
     {
         if (isValid (r, c))
         {
-            const int index = getIndexForCell (r, c);
-            toggled.setBit (index, on);
+            if (on) wordFor (r, c) |= bitFor (c);
+            else    wordFor (r, c) &= ~bitFor (c);
         }
     }
     
@@ -72,12 +74,11 @@ public:
     {
         if (! isValid (row, column))
             return;
-        const int index = getIndexForCell (row, column);
-        toggled.setBit (index, false);
+        wordFor (row, column) &= ~bitFor (column);
     }
     
     inline bool connected (const int row, const int col) const {
-        return toggled [getIndexForCell (row, col)];
+        return isValid (row, col) && (wordFor (row, col) & bitFor (col)) != 0;
     }
     
     inline bool isCellToggled (int r, int c) const { return connected (r, c); }
@@ -85,15 +86,56 @@ public:
     {
         if (isValid (row, column))
         {
-            const int index = getIndexForCell (row, column);
-            toggled.setBit (index, ! toggled[index]);
+            wordFor (row, column) ^= bitFor (column);
             return true;
         }
 
         return false;
     }
 
-    inline bool connectedAtIndex (const int index) const { return toggled [index]; }
+    inline bool connectedAtIndex (const int index) const
+    {
+        return numColumns > 0 && connected (index / numColumns, index % numColumns);
+    }
+
+    /** Turn every cell in a row on or off */
+    void setRow (int row, bool on);
+
+    /** Turn every cell in a column on or off */
+    void setColumn (int column, bool on);
+
+    inline void clearRow (int row)          { setRow (row, false); }
+    inline void clearColumn (int column)    { setColumn (column, false); }
+
+    /** Turn every cell off */
+    void clear();
+
+    /** Copy the cells of one row over another */
+    void copyRow (int sourceRow, int destRow);
+
+    /** Copy the cells of one column over another */
+    void copyColumn (int sourceColumn, int destColumn);
+
+    /** Returns true if no cell in the row is on */
+    bool isRowEmpty (int row) const;
+
+    /** Returns the number of cells that are on */
+    int getNumConnected() const;
+
+    /** Returns the first column at or after startColumn which is on in the
+        given row, or -1. Skips empty stretches a word at a time */
+    int findNextConnected (int row, int startColumn) const;
+
+    /** Encode the cells in row major order.
+        @param runLength    If true, writes alternating off/on run lengths as
+                            variable length integers, which is compact for
+                            sparse matrices. Otherwise writes one bit per cell */
+    MemoryBlock encodeCells (bool runLength) const;
+
+    /** Restore cells written by encodeCells. The matrix must already have the
+        size it had when encoded.
+        @returns false if the data was malformed */
+    bool decodeCells (const void* data, size_t size, bool runLength);
 
    #if JUCE_MODULE_AVAILABLE_juce_data_structures
     inline ValueTree createValueTree (const String& type = "matrix") const
@@ -101,15 +143,33 @@ public:
         ValueTree tree (Identifier::isValidIdentifier(type) ? type : "matrix");
         tree.setProperty ("numRows", numRows, nullptr);
         tree.setProperty ("numColumns", numColumns, nullptr);
-        tree.setProperty ("toggled", toggled.toString(2), nullptr);
+
+        // keep whichever encoding is smaller
+        const MemoryBlock runs (encodeCells (true)), bits (encodeCells (false));
+        const bool useRuns = runs.getSize() <= bits.getSize();
+        tree.setProperty ("encoding", useRuns ? "rle" : "bits", nullptr);
+        tree.setProperty ("cells", (useRuns ? runs : bits).toBase64Encoding(), nullptr);
         return tree;
     }
 
     inline void restoreFromValueTree (const ValueTree& tree)
     {
-        numRows = tree.getProperty ("numRows", 0);
-        numColumns = tree.getProperty ("numColumns", 0);
-        toggled.parseString (tree.getProperty("toggled").toString(), 2);
+        resize (tree.getProperty ("numRows", 0), tree.getProperty ("numColumns", 0));
+
+        if (tree.hasProperty ("cells"))
+        {
+            MemoryBlock block;
+            if (block.fromBase64Encoding (tree.getProperty ("cells").toString()))
+                decodeCells (block.getData(), block.getSize(), tree.getProperty ("encoding").toString() == "rle");
+        }
+        else
+        {
+            // sessions saved before the packed encoding store a binary string
+            BigInteger toggled;
+            toggled.parseString (tree.getProperty("toggled").toString(), 2);
+            for (int bit = toggled.findNextSetBit (0); bit >= 0; bit = toggled.findNextSetBit (bit + 1))
+                setIndex (bit);
+        }
     }
    #endif
     
@@ -130,15 +190,125 @@ public:
     MatrixState& operator= (const MatrixState& o) {
         this->numRows = o.numRows;
         this->numColumns = o.numColumns;
-        this->toggled = o.toggled;
+        this->wordsPerRow = o.wordsPerRow;
+        this->words = o.words;
         return *this;
     }
     
     const bool operator==(const MatrixState& o) const {
-        return this->sameSizeAs(o) && this->toggled == o.toggled;
+        return this->sameSizeAs(o) && this->words == o.words;
     }
     
 private:
-    BigInteger toggled;
-    int numRows, numColumns;
+    Array<uint64> words;
+    int numRows, numColumns, wordsPerRow;
+
+    inline uint64& wordFor (int row, int column)
+    {
+        return words.getReference (row * wordsPerRow + (column >> 6));
+    }
+
+    inline uint64 wordFor (int row, int column) const
+    {
+        return words.getUnchecked (row * wordsPerRow + (column >> 6));
+    }
+
+    inline static uint64 bitFor (int column) { return (uint64) 1 << (column & 63); }
+
+    /** Mask of the bits in use in the last word of each row */
+    inline uint64 lastWordMask() const
+    {
+        return (numColumns & 63) == 0 ? ~(uint64) 0 : (((uint64) 1 << (numColumns & 63)) - 1);
+    }
+
+    inline void setIndex (int index)
+    {
+        if (numColumns > 0)
+            connect (index / numColumns, index % numColumns);
+    }
+};
+
+/** Hands a MatrixState from an editing thread to the audio thread without
+    locks.
+
+    publish() builds a snapshot holding a copy of the matrix plus a sparse,
+    row sorted list of its connected cells, then swaps it in. The audio
+    thread calls acquire() at the start of each block and mixes from the
+    connection list, so it only visits cells that are on.
+
+    Snapshots are triple buffered: the reader's buffer, the newest
+    published one and a spare for the writer. Neither side ever waits or
+    sees a buffer while it is being filled. Only one thread may publish. */
+class RealtimeMatrixState
+{
+public:
+    /** A connected cell */
+    struct Connection
+    {
+        int row;
+        int column;
+    };
+
+    /** A published matrix, read only for the audio thread */
+    class Snapshot
+    {
+    public:
+        Snapshot() : version (0) { }
+
+        /** The full matrix, for random access */
+        inline const MatrixState& getState() const noexcept { return state; }
+
+        /** The connected cells, sorted by row then column */
+        inline int getNumConnections() const noexcept { return connections.size(); }
+        inline const Connection& getConnection (int index) const noexcept { return connections.getReference (index); }
+        inline const Connection* begin() const noexcept { return connections.begin(); }
+        inline const Connection* end() const noexcept { return connections.end(); }
+
+        /** Returns the connection indexes for one row */
+        inline Range<int> getRowRange (int row) const noexcept
+        {
+            return isPositiveAndBelow (row, state.getNumRows())
+                ? Range<int> (rowStarts.getUnchecked (row), rowStarts.getUnchecked (row + 1))
+                : Range<int>();
+        }
+
+        /** Counts up each time a snapshot is published, zero until the first */
+        inline uint32 getVersion() const noexcept { return version; }
+
+    private:
+        friend class RealtimeMatrixState;
+        MatrixState state;
+        Array<Connection> connections;
+        Array<int> rowStarts;   ///< first connection of each row, plus one past the end
+        uint32 version;
+
+        JUCE_DECLARE_NON_COPYABLE (Snapshot)
+    };
+
+    RealtimeMatrixState() : middle (1), back (2), front (0), lastVersion (0) { }
+
+    /** Publish a new matrix (editing thread). Allocates, not realtime safe */
+    void publish (const MatrixState& matrix);
+
+    /** Returns the newest published snapshot (audio thread). Lock free and
+        realtime safe. The snapshot stays valid until the next acquire() */
+    const Snapshot& acquire() noexcept
+    {
+        if (middle.load (std::memory_order_relaxed) & newFlag)
+            front = middle.exchange (front, std::memory_order_acq_rel) & indexMask;
+        return buffers [front];
+    }
+
+    /** Returns true if a snapshot was published since the last acquire() */
+    bool hasNewSnapshot() const noexcept { return (middle.load (std::memory_order_relaxed) & newFlag) != 0; }
+
+private:
+    enum { indexMask = 3, newFlag = 4 };
+    Snapshot buffers [3];
+    std::atomic<int> middle;    ///< index of the buffer between the threads, plus newFlag
+    int back;                   ///< writer's buffer
+    int front;                  ///< reader's buffer
+    uint32 lastVersion;
+
+    JUCE_DECLARE_NON_COPYABLE (RealtimeMatrixState)
 };
@@ -0,0 +1,133 @@
+/*
+    This file is part of the Kushview Modules for JUCE
+    Copyright (c) 2014-2019  Kushview, LLC.  All rights reserved.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+namespace MonitorHelpers
+{
+    inline uint32 toBits (float value) noexcept
+    {
+        uint32 bits;
+        memcpy (&bits, &value, sizeof (bits));
+        return bits;
+    }
+
+    inline float fromBits (uint32 bits) noexcept
+    {
+        float value;
+        memcpy (&value, &bits, sizeof (value));
+        return value;
+    }
+}
+
+MonitorBank::MonitorBank (int channels, int holdCycles, float decay)
+    : numChannels (jmax (0, channels)),
+      peakHoldCycles (jmax (0, holdCycles)),
+      peakDecay (jlimit (0.0f, 1.0f, decay))
+{
+    accumulators.calloc ((size_t) numChannels);
+    block.allocate ((size_t) numChannels * 2, false);
+    for (int i = 0; i < numChannels * 2; ++i)
+        new (block.getData() + i) std::atomic<uint32> (0);
+}
+
+MonitorBank::~MonitorBank() { }
+
+void MonitorBank::addSamples (int channel, const float* samples, int numSamples) noexcept
+{
+    jassert (isPositiveAndBelow (channel, numChannels));
+    if (! isPositiveAndBelow (channel, numChannels) || numSamples <= 0)
+        return;
+
+    Accumulator& acc = accumulators [channel];
+    const Range<float> range (FloatVectorOperations::findMinAndMax (samples, numSamples));
+    acc.peak = jmax (acc.peak, range.getEnd(), -range.getStart());
+
+    double sum = 0.0;
+    for (int i = 0; i < numSamples; ++i)
+        sum += (double) samples[i] * (double) samples[i];
+    acc.sumOfSquares += sum;
+    acc.numSamples   += numSamples;
+}
+
+void MonitorBank::publish() noexcept
+{
+    using namespace MonitorHelpers;
+    sequence.beginWrite();
+
+    for (int i = 0; i < numChannels; ++i)
+    {
+        Accumulator& acc = accumulators [i];
+
+        if (acc.peak >= acc.heldPeak)
+        {
+            acc.heldPeak = acc.peak;
+            acc.holdRemaining = peakHoldCycles;
+        }
+        else if (acc.holdRemaining > 0)
+        {
+            --acc.holdRemaining;
+        }
+        else
+        {
+            acc.heldPeak = jmax (acc.peak, acc.heldPeak * peakDecay);
+        }
+
+        const float rms = acc.numSamples > 0 ? (float) std::sqrt (acc.sumOfSquares / acc.numSamples) : 0.0f;
+        block[i].store (toBits (acc.heldPeak), std::memory_order_release);
+        block[numChannels + i].store (toBits (rms), std::memory_order_release);
+
+        acc.peak = 0.0f;
+        acc.sumOfSquares = 0.0;
+        acc.numSamples = 0;
+    }
+
+    sequence.endWrite();
+}
+
+bool MonitorBank::read (Snapshot& snapshot, int maxAttempts) const
+{
+    using namespace MonitorHelpers;
+    snapshot.peaks.resize (numChannels);
+    snapshot.rms.resize (numChannels);
+    float* const peaks = snapshot.peaks.getRawDataPointer();
+    float* const rms   = snapshot.rms.getRawDataPointer();
+
+    for (int attempt = 0; attempt < jmax (1, maxAttempts); ++attempt)
+    {
+        uint32 ticket;
+        if (! sequence.beginRead (ticket))
+        {
+            Thread::yield();
+            continue;
+        }
+
+        for (int i = 0; i < numChannels; ++i)
+        {
+            peaks[i] = fromBits (block[i].load (std::memory_order_acquire));
+            rms[i]   = fromBits (block[numChannels + i].load (std::memory_order_acquire));
+        }
+
+        if (sequence.validate (ticket))
+        {
+            snapshot.cycle = SeqLock::versionOf (ticket);
+            return true;
+        }
+    }
+
+    return false;
+}
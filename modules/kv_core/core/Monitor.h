@@ -32,7 +32,7 @@ public:
     const Array<int> path;
     const int port;
 
-    const int procNode() const { return *path.end(); }
+    const int procNode() const { return path.getLast(); }
 
     /** The non-realtime thread should call this at regular intervals */
     inline float get() const {
@@ -50,3 +50,71 @@ private:
     AtomicValue<float> value;
 
 };
+
+/** A bank of level meters written by the audio thread and read by the GUI.
+
+    The audio thread feeds samples to any number of channels during a cycle,
+    which accumulates each channel's peak and sum of squares, then calls
+    publish() once at the end of the cycle. publish() works out the RMS and
+    held peak of every channel and writes them all into one contiguous block.
+
+    Readers copy the whole block with read(), so every value in a snapshot
+    comes from the same cycle, at the cost of one copy instead of a poll per
+    monitor. The block is guarded by a SeqLock: the writer never waits,
+    and a reader retries if it overlapped a publish. Any number of
+    threads may read. */
+class MonitorBank
+{
+public:
+    /** Values from one published cycle */
+    struct Snapshot
+    {
+        Snapshot() : cycle (0) { }
+
+        Array<float> peaks;     ///< held peak of each channel
+        Array<float> rms;       ///< RMS of each channel over the cycle
+        uint32 cycle;           ///< number of the cycle, zero if nothing was published yet
+    };
+
+    /** Create a bank.
+        @param numChannels      Number of meters
+        @param peakHoldCycles   Cycles a peak is held before it starts to fall
+        @param peakDecay        Factor the held peak falls by each cycle after that */
+    MonitorBank (int numChannels, int peakHoldCycles = 0, float peakDecay = 0.0f);
+    ~MonitorBank();
+
+    /** Returns the number of channels */
+    inline int getNumChannels() const noexcept { return numChannels; }
+
+    /** Accumulate samples for a channel (audio thread) */
+    void addSamples (int channel, const float* samples, int numSamples) noexcept;
+
+    /** Publish every channel for this cycle and start the next (audio thread) */
+    void publish() noexcept;
+
+    /** Copy the most recently published cycle (any thread but the writer).
+        @returns false if a consistent copy couldn't be made in time */
+    bool read (Snapshot& snapshot, int maxAttempts = 100) const;
+
+    /** Returns the number of the last published cycle */
+    inline uint32 getCycle() const noexcept { return sequence.getVersion(); }
+
+private:
+    struct Accumulator
+    {
+        float peak;
+        double sumOfSquares;
+        int numSamples;
+        float heldPeak;
+        int holdRemaining;
+    };
+
+    const int numChannels;
+    const int peakHoldCycles;
+    const float peakDecay;
+    HeapBlock<Accumulator> accumulators;    ///< writer only
+    HeapBlock<std::atomic<uint32>> block;   ///< float bits, peaks then RMS
+    SeqLock sequence;                       ///< counts published cycles
+
+    JUCE_DECLARE_NON_COPYABLE (MonitorBank)
+};
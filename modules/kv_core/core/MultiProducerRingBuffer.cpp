@@ -0,0 +1,173 @@
+/*
+    This file is part of the Kushview Modules for JUCE
+    Copyright (c) 2014-2019  Kushview, LLC.  All rights reserved.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+static_assert (sizeof (std::atomic<uint32>) == sizeof (uint32),
+               "Message headers are stored in place as atomic words");
+
+MultiProducerRingBuffer::MultiProducerRingBuffer (int32 newCapacity)
+    : writeHead (0), readHead (0)
+{
+    capacity = (uint32) nextPowerOfTwo (jmax (newCapacity, (int32) 16));
+    mask     = capacity - 1;
+
+    // headers are read as 'not committed' until a writer sets them, so the
+    // whole block has to start out zeroed
+    block.calloc (capacity);
+}
+
+MultiProducerRingBuffer::~MultiProducerRingBuffer()
+{
+    block.free();
+}
+
+void MultiProducerRingBuffer::getVectors (uint32 position, uint32 bytes, RingBuffer::Vector* vec) const
+{
+    const uint32 start = position & mask;
+    const uint32 size1 = jmin (bytes, capacity - start);
+    vec[0].buffer = block.getData() + start;
+    vec[0].size   = size1;
+    vec[1].buffer = block.getData();
+    vec[1].size   = bytes - size1;
+}
+
+MultiProducerRingBuffer::Reservation
+MultiProducerRingBuffer::reserve (uint32 tag, uint32 bodySize)
+{
+    Reservation r;
+    const uint32 total = requiredSpace (bodySize);
+    if (bodySize >= committedFlag || total > capacity)
+        return r;
+
+    uint32 head = writeHead.load (std::memory_order_relaxed);
+    for (;;)
+    {
+        const uint32 tail = readHead.load (std::memory_order_acquire);
+        if (capacity - (head - tail) < total)
+            return r;
+
+        if (writeHead.compare_exchange_weak (head, head + total,
+                                             std::memory_order_acq_rel,
+                                             std::memory_order_relaxed))
+            break;
+    }
+
+    // header is 8 byte aligned and never wraps, only the body can
+    *reinterpret_cast<uint32*> (block.getData() + ((head + sizeof (uint32)) & mask)) = tag;
+    getVectors (head + headerSize, bodySize, r.vec);
+    r.position = head;
+    r.bodySize = bodySize;
+    r.reserved = true;
+    return r;
+}
+
+void MultiProducerRingBuffer::commit (const Reservation& r)
+{
+    jassert (r.isValid());
+    if (r.isValid())
+        headerAt (r.position).store (r.bodySize | committedFlag, std::memory_order_release);
+}
+
+bool MultiProducerRingBuffer::write (uint32 tag, const void* data, uint32 bodySize)
+{
+    const Reservation r (reserve (tag, bodySize));
+    if (! r.isValid())
+        return false;
+
+    if (r.vec[0].size > 0)
+        memcpy (r.vec[0].buffer, data, r.vec[0].size);
+    if (r.vec[1].size > 0)
+        memcpy (r.vec[1].buffer, (const uint8*) data + r.vec[0].size, r.vec[1].size);
+
+    commit (r);
+    return true;
+}
+
+bool MultiProducerRingBuffer::peek (uint32& bodySize, uint32& tag) const
+{
+    const uint32 tail   = readHead.load (std::memory_order_relaxed);
+    const uint32 header = headerAt (tail).load (std::memory_order_acquire);
+    if ((header & committedFlag) == 0)
+        return false;
+
+    bodySize = header & ~committedFlag;
+    tag      = *reinterpret_cast<const uint32*> (block.getData() + ((tail + sizeof (uint32)) & mask));
+    return true;
+}
+
+uint32 MultiProducerRingBuffer::getReadVector (RingBuffer::Vector* vec) const
+{
+    uint32 bodySize = 0, tag = 0;
+    if (! peek (bodySize, tag))
+    {
+        vec[0].size = vec[1].size = 0;
+        vec[0].buffer = vec[1].buffer = nullptr;
+        return 0;
+    }
+
+    getVectors (readHead.load (std::memory_order_relaxed) + headerSize, bodySize, vec);
+    return bodySize;
+}
+
+uint32 MultiProducerRingBuffer::read (void* dest, uint32 destSize)
+{
+    RingBuffer::Vector vec[2];
+    const uint32 bodySize = getReadVector (vec);
+    if (bodySize == 0)
+    {
+        uint32 size = 0, tag = 0;
+        if (peek (size, tag))
+            finishedRead();
+        return 0;
+    }
+
+    jassert (bodySize <= destSize);
+    if (bodySize > destSize)
+    {
+        finishedRead();
+        return 0;
+    }
+
+    memcpy (dest, vec[0].buffer, vec[0].size);
+    if (vec[1].size > 0)
+        memcpy ((uint8*) dest + vec[0].size, vec[1].buffer, vec[1].size);
+
+    finishedRead();
+    return bodySize;
+}
+
+void MultiProducerRingBuffer::finishedRead()
+{
+    uint32 bodySize = 0, tag = 0;
+    if (! peek (bodySize, tag))
+        return;
+
+    const uint32 tail  = readHead.load (std::memory_order_relaxed);
+    const uint32 total = requiredSpace (bodySize);
+
+    // Any aligned word in this region may become a header for a later
+    // message, so clear it all before handing the space back to writers
+    headerAt (tail).store (0, std::memory_order_relaxed);
+    RingBuffer::Vector vec[2];
+    getVectors (tail + headerSize, total - headerSize, vec);
+    memset (vec[0].buffer, 0, vec[0].size);
+    if (vec[1].size > 0)
+        memset (vec[1].buffer, 0, vec[1].size);
+
+    readHead.store (tail + total, std::memory_order_release);
+}
@@ -0,0 +1,120 @@
+/*
+    This file is part of the Kushview Modules for JUCE
+    Copyright (c) 2014-2019  Kushview, LLC.  All rights reserved.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#pragma once
+
+/** A lock-free, multi-producer single-consumer message ring.
+
+    Each message is a tag plus a variable sized body. Writers reserve space
+    for a whole message with a single compare-and-swap, fill it in, then
+    commit it. The reader only ever sees committed messages, so a message can
+    never be observed half written regardless of how many threads write.
+
+    Messages are delivered in reservation order. If a writer is pre-empted
+    between reserve and commit, messages reserved after it are held back
+    until it commits. */
+class MultiProducerRingBuffer
+{
+public:
+    /** A reserved region to be filled by a writer */
+    struct Reservation
+    {
+        Reservation() : position (0), bodySize (0), reserved (false)
+        {
+            vec[0].size = vec[1].size = 0;
+            vec[0].buffer = vec[1].buffer = nullptr;
+        }
+
+        /** Returns true if space was reserved */
+        inline bool isValid() const { return reserved; }
+
+        /** The body region(s). vec[1] is empty unless the body wraps */
+        RingBuffer::Vector vec[2];
+
+    private:
+        friend class MultiProducerRingBuffer;
+        uint32 position;
+        uint32 bodySize;
+        bool reserved;
+    };
+
+    explicit MultiProducerRingBuffer (int32 capacity);
+    ~MultiProducerRingBuffer();
+
+    /** Returns the size of the buffer in bytes */
+    inline size_t size() const { return (size_t) capacity; }
+
+    /** Returns the number of bytes a message with the given body size occupies */
+    inline static uint32 requiredSpace (uint32 bodySize) { return (headerSize + bodySize + 7u) & ~7u; }
+
+    /** Returns true if a message of the given body size could currently fit.
+        Another writer may still claim the space before you reserve it */
+    inline bool canWrite (uint32 bodySize) const
+    {
+        return requiredSpace (bodySize) <= capacity - (writeHead.load (std::memory_order_relaxed) -
+                                                       readHead.load (std::memory_order_acquire));
+    }
+
+    /** Reserve space for a message (any thread, realtime safe)
+        Returns an invalid Reservation if there isn't enough space. A valid
+        reservation MUST be committed, otherwise the reader will stall on it */
+    Reservation reserve (uint32 tag, uint32 bodySize);
+
+    /** Publish a reserved message to the reader */
+    void commit (const Reservation& reservation);
+
+    /** Reserve, copy and commit a message in one go (any thread, realtime safe) */
+    bool write (uint32 tag, const void* data, uint32 bodySize);
+
+    /** Returns true if the next message is committed (reader thread)
+        @param bodySize Set to the body size of the next message
+        @param tag      Set to the tag of the next message */
+    bool peek (uint32& bodySize, uint32& tag) const;
+
+    /** Get the body of the next committed message without copying it
+        (reader thread). Call finishedRead when done with it.
+        @returns The body size, or zero if no message is ready */
+    uint32 getReadVector (RingBuffer::Vector* vec) const;
+
+    /** Copy the body of the next message and release it (reader thread)
+        @returns The number of bytes copied, or zero if no message is ready */
+    uint32 read (void* dest, uint32 destSize);
+
+    /** Release the next message so its space can be reused (reader thread) */
+    void finishedRead();
+
+private:
+    enum { headerSize = 2 * sizeof (uint32) };
+    static const uint32 committedFlag = 0x80000000;
+
+    HeapBlock<uint8> block;
+    uint32 capacity;
+    uint32 mask;
+    std::atomic<uint32> writeHead;
+    std::atomic<uint32> readHead;
+
+    inline std::atomic<uint32>& headerAt (uint32 position) const
+    {
+        return *reinterpret_cast<std::atomic<uint32>*> (block.getData() + (position & mask));
+    }
+
+    void getVectors (uint32 position, uint32 bytes, RingBuffer::Vector* vec) const;
+
+    JUCE_DECLARE_NON_COPYABLE (MultiProducerRingBuffer)
+};
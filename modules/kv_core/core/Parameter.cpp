@@ -0,0 +1,134 @@
+/*
+    This file is part of the Kushview Modules for JUCE
+    Copyright (c) 2014-2019  Kushview, LLC.  All rights reserved.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+
+SmoothedParameter::SmoothedParameter (float initialValue, RampType type)
+    : pendingTarget (initialValue), target (initialValue), current (initialValue),
+      step (0.0f), remaining (0), rampLength (0), multiplying (false), rampType (type)
+{ }
+
+void SmoothedParameter::prepare (double sampleRate, double rampSeconds)
+{
+    rampLength = jmax (0, roundToInt (sampleRate * rampSeconds));
+    setCurrentAndTargetValue (pendingTarget.load (std::memory_order_relaxed));
+}
+
+void SmoothedParameter::setCurrentAndTargetValue (float newValue) noexcept
+{
+    pendingTarget.store (newValue, std::memory_order_relaxed);
+    target = current = newValue;
+    remaining = 0;
+}
+
+void SmoothedParameter::startRamp() noexcept
+{
+    target = pendingTarget.load (std::memory_order_relaxed);
+    if (rampLength <= 0 || target == current)
+    {
+        current = target;
+        remaining = 0;
+        return;
+    }
+
+    remaining = rampLength;
+
+    // a multiplicative ramp can't cross or touch zero, fall back to linear
+    multiplying = rampType == Multiplicative && current * target > 0.0f;
+    if (multiplying)
+        step = (float) std::exp (std::log ((double) target / (double) current) / (double) rampLength);
+    else
+        step = (target - current) / (float) rampLength;
+}
+
+void SmoothedParameter::fill (float* dest, int numSamples) noexcept
+{
+    if (pendingTarget.load (std::memory_order_relaxed) != target)
+        startRamp();
+
+    const int numRamped = jmin (numSamples, remaining);
+
+    // Each sample is worked out from the value at the start of the ramp
+    // block rather than from the previous sample, so the four lanes don't
+    // depend on each other and the compiler can vectorise the loops.
+    int i = 0;
+    if (! multiplying)
+    {
+        const float start = current, inc = step;
+        for (; i < numRamped; ++i)
+            dest[i] = start + inc * (float) (i + 1);
+    }
+    else
+    {
+        float lanes[4], ratio4;
+        lanes[0] = current * step;
+        lanes[1] = lanes[0] * step;
+        lanes[2] = lanes[1] * step;
+        lanes[3] = lanes[2] * step;
+        ratio4 = (step * step) * (step * step);
+
+        for (; i + 4 <= numRamped; i += 4)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                dest[i + j] = lanes[j];
+                lanes[j] *= ratio4;
+            }
+        }
+
+        for (int j = 0; i < numRamped; ++i, ++j)
+            dest[i] = lanes[j];
+    }
+
+    remaining -= numRamped;
+    if (remaining <= 0)
+    {
+        // land exactly on the target, whatever rounding crept in
+        current = target;
+        remaining = 0;
+        if (numRamped > 0)
+            dest[numRamped - 1] = target;
+    }
+    else if (numRamped > 0)
+    {
+        current = dest[numRamped - 1];
+    }
+
+    if (numSamples > numRamped)
+        FloatVectorOperations::fill (dest + numRamped, current, numSamples - numRamped);
+}
+
+void SmoothedParameter::applyGain (float* samples, int numSamples) noexcept
+{
+    if (! isSmoothing())
+    {
+        if (current != 1.0f)
+            FloatVectorOperations::multiply (samples, current, numSamples);
+        return;
+    }
+
+    float ramp [64];
+    while (numSamples > 0)
+    {
+        const int n = jmin (numSamples, (int) numElementsInArray (ramp));
+        fill (ramp, n);
+        FloatVectorOperations::multiply (samples, ramp, n);
+        samples += n;
+        numSamples -= n;
+    }
+}
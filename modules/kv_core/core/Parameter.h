@@ -45,6 +45,34 @@ public:
         return min + (max - min) * ((exp (k * x) - 1) / (exp (k) - 1));
     }
 
+    /** mapLog and mapExp with the constants for a range and curve worked out
+        once. Keep one around instead of calling the static versions per
+        sample. */
+    struct LogMapping
+    {
+        LogMapping (double min_, double max_, double k)
+            : min (min_), range (max_ - min_),
+              invRange (1.0 / (max_ - min_)),
+              invK (1.0 / k), curve (k),
+              expKMinusOne (exp (k) - 1.0),
+              invExpKMinusOne (1.0 / (exp (k) - 1.0))
+        { }
+
+        /** Map a value in min-max to 0-1 on a log curve */
+        inline double mapLog (double value) const
+        {
+            return log (1.0 + (value - min) * invRange * expKMinusOne) * invK;
+        }
+
+        /** Map 0-1 to min-max on an exponential curve */
+        inline double mapExp (double x) const
+        {
+            return min + range * ((exp (curve * x) - 1.0) * invExpKMinusOne);
+        }
+
+        double min, range, invRange, invK, curve, expKMinusOne, invExpKMinusOne;
+    };
+
     /** Get this parameter's name */
     const String& getName()   const { return name; }
 
@@ -81,6 +109,8 @@ public:
         else
             seed.maxMinRatio = seed.max / seed.min;
 
+        seed.logMaxMinRatio = seed.maxMinRatio > 0.0 ? log (seed.maxMinRatio) : 0.0;
+
         setValue (value);
     }
 
@@ -126,7 +156,7 @@ public:
     inline double
     getValueLogarithmic() const
     {
-        return seed.min * pow (seed.maxMinRatio, getNormalValue());
+        return seed.min * exp (seed.logMaxMinRatio * getNormalValue());
     }
 
     /** Reset to min = 0.0, max =1.0, value == 1.0 */
@@ -134,6 +164,7 @@ public:
     reset()
     {
         seed.maxMinRatio = 1.0;
+        seed.logMaxMinRatio = 0.0;
         seed.min         = 0;
         seed.max         = 1;
         seed.value       = 1;
@@ -154,13 +185,69 @@ private:
     struct Seed
     {
         Seed() : min (0.0), max (1.0), value (1.0),
-                 maxMinRatio (1.0)
+                 maxMinRatio (1.0), logMaxMinRatio (0.0)
         { }
 
         double min, max, value;
-        double maxMinRatio; // cached min / max (not used yet)
+        double maxMinRatio;     // cached max / min
+        double logMaxMinRatio;  // cached log (max / min)
 
     };
 
     Seed seed;
 };
+
+/** A parameter value for DSP code, smoothed per sample.
+
+    Any thread can set a new target, the audio thread picks it up at the
+    start of the next block and ramps to it over the ramp time. Linear ramps
+    add a fixed step per sample, multiplicative ramps multiply by a fixed
+    ratio, which suits gains and frequencies. The step or ratio is worked
+    out once when a ramp starts, so generating a ramp takes only adds or
+    multiplies, four samples at a time. */
+class SmoothedParameter
+{
+public:
+    enum RampType
+    {
+        Linear = 0,
+        Multiplicative
+    };
+
+    explicit SmoothedParameter (float initialValue = 0.0f, RampType type = Linear);
+
+    /** Set the ramp time. Not realtime safe, call before processing starts */
+    void prepare (double sampleRate, double rampSeconds);
+
+    /** Set a new value to ramp to. Realtime safe, any thread */
+    inline void setTargetValue (float newTarget) noexcept { pendingTarget.store (newTarget, std::memory_order_relaxed); }
+
+    /** Returns the most recently set target */
+    inline float getTargetValue() const noexcept { return pendingTarget.load (std::memory_order_relaxed); }
+
+    /** Jump to a value without ramping (audio thread) */
+    void setCurrentAndTargetValue (float newValue) noexcept;
+
+    /** Returns the value the next generated sample ramps from (audio thread) */
+    inline float getCurrentValue() const noexcept { return current; }
+
+    /** Returns true if a ramp is in progress or a new target is waiting */
+    inline bool isSmoothing() const noexcept { return remaining > 0 || pendingTarget.load (std::memory_order_relaxed) != target; }
+
+    /** Write the next numSamples values of the ramp (audio thread) */
+    void fill (float* dest, int numSamples) noexcept;
+
+    /** Multiply samples by the ramp, for gain parameters (audio thread) */
+    void applyGain (float* samples, int numSamples) noexcept;
+
+private:
+    std::atomic<float> pendingTarget;
+    float target, current, step;
+    int remaining, rampLength;
+    bool multiplying;
+    const RampType rampType;
+
+    void startRamp() noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE (SmoothedParameter)
+};
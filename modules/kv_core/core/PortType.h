@@ -46,7 +46,7 @@ public:
     };
 
     PortType (const Identifier& identifier)
-        : type (typeForString (identifier.toString())) { }
+        : type (typeForIdentifier (identifier)) { }
     
     PortType (const String& identifier)
         : type (typeForString (identifier)) { }
@@ -128,68 +128,124 @@ public:
         return res;
     }
 
+    /** Returns the URI of a port type as a string literal */
+    static constexpr const char* getURILiteral (int t)
+    {
+        return t == Control ? "http://lv2plug.in/ns/lv2core#ControlPort"
+             : t == Audio   ? "http://lv2plug.in/ns/lv2core#AudioPort"
+             : t == CV      ? "http://lv2plug.in/ns/lv2core#CVPort"
+             : t == Atom    ? "http://lv2plug.in/ns/lv2core#AtomPort"
+             : t == Event   ? "http://lv2plug.in/ns/lv2core#EventPort"
+             : t == Midi    ? "https://kushview.net/ns/element#MidiPort"
+             : "http://lvtoolkit.org/ns/lvtk#null";
+    }
+
+    /** Returns the name of a port type as a string literal */
+    static constexpr const char* getNameLiteral (int t)
+    {
+        return t == Control ? "Control"
+             : t == Audio   ? "Audio"
+             : t == CV      ? "CV"
+             : t == Atom    ? "Atom"
+             : t == Event   ? "Event"
+             : t == Midi    ? "MIDI"
+             : "Unknown";
+    }
+
+    /** Returns the slug of a port type as a string literal */
+    static constexpr const char* getSlugLiteral (int t)
+    {
+        return t == Control ? "control"
+             : t == Audio   ? "audio"
+             : t == CV      ? "cv"
+             : t == Atom    ? "atom"
+             : t == Event   ? "event"
+             : t == Midi    ? "midi"
+             : "unknown";
+    }
+
 private:
+    /** Strings and interned Identifiers for every type, built once. Strings
+        resolve with one hash and one compare. Identifiers are pooled, so
+        they resolve by hashing the pooled string's address. */
+    struct Names
+    {
+        /** Hashes a pooled string by address */
+        struct PointerHash
+        {
+            static int generateHash (const char* key, int upperLimit) noexcept
+            {
+                return (int) ((((pointer_sized_uint) key) >> 3) % (pointer_sized_uint) upperLimit);
+            }
+        };
+
+        Names()
+        {
+            for (int i = 0; i <= Unknown; ++i)
+            {
+                uris.add (getURILiteral (i));
+                names.add (getNameLiteral (i));
+                slugs.add (getSlugLiteral (i));
+            }
+
+            for (int i = 0; i <= Midi; ++i)
+            {
+                for (const auto& s : { slugs[i], uris[i], names[i] })
+                {
+                    // stored one based, so a miss (zero) needs no second lookup
+                    if (! lookup.contains (s))
+                        lookup.set (s, i + 1);
+                    const Identifier pooled (s);
+                    identifiers.add (pooled);
+                    if (! identifierLookup.contains (pooled.getCharPointer().getAddress()))
+                        identifierLookup.set (pooled.getCharPointer().getAddress(), i + 1);
+                }
+            }
+        }
+
+        static const Names& get()
+        {
+            static const Names names;
+            return names;
+        }
+
+        StringArray uris, names, slugs;
+        HashMap<String, int> lookup;
+        Array<Identifier> identifiers;      // keeps the pooled strings alive
+        HashMap<const char*, int, PointerHash> identifierLookup;
+    };
+
     /** @internal */
     static inline const String& typeURI (unsigned id)
     {
         jassert (id <= Midi);
-
-        static const String uris[] = {
-            String ("http://lv2plug.in/ns/lv2core#ControlPort"),
-            String ("http://lv2plug.in/ns/lv2core#AudioPort"),
-            String ("http://lv2plug.in/ns/lv2core#CVPort"),
-            String ("http://lv2plug.in/ns/lv2core#AtomPort"),
-            String ("http://lv2plug.in/ns/lv2core#EventPort"),
-            String ("https://kushview.net/ns/element#MidiPort"),
-            String ("http://lvtoolkit.org/ns/lvtk#null")
-        };
-
-        return uris [id];
+        return Names::get().uris [(int) id];
     }
 
     /** @internal */
     static inline const String& typeName (unsigned id)
     {
         jassert (id <= Midi);
-        static const String uris[] = {
-            String ("Control"),
-            String ("Audio"),
-            String ("CV"),
-            String ("Atom"),
-            String ("Event"),
-            String ("MIDI"),
-            String ("Unknown")
-        };
-        return uris [id];
+        return Names::get().names [(int) id];
     }
 
     /** @internal */
     static inline const String& slugName (unsigned id)
     {
         jassert (id <= Midi);
-        static const String slugs[] = {
-            String ("control"),
-            String ("audio"),
-            String ("cv"),
-            String ("atom"),
-            String ("event"),
-            String ("midi"),
-            String ("unknown")
-        };
-        return slugs [id];
+        return Names::get().slugs [(int) id];
     }
-    
+
     static inline ID typeForString (const String& identifier)
     {
-        for (int i = 0; i <= Midi; ++i)
-        {
-            if (slugName(i) == identifier || typeURI(i) == identifier ||
-                typeName(i) == identifier)
-            {
-                return static_cast<ID> (i);
-            }
-        }
-        return Unknown;
+        const int t = Names::get().lookup [identifier];
+        return t > 0 ? static_cast<ID> (t - 1) : Unknown;
+    }
+
+    static inline ID typeForIdentifier (const Identifier& identifier)
+    {
+        const int t = Names::get().identifierLookup [identifier.getCharPointer().getAddress()];
+        return t > 0 ? static_cast<ID> (t - 1) : Unknown;
     }
 
     ID type;
@@ -549,3 +605,208 @@ public:
     }
 #endif
 };
+
+/** A flattened, read-only lookup between ports and channels.
+
+    ChannelMapping and PortList answer the same questions, but through
+    nested arrays or a linear search. Build a ChannelMap once whenever the
+    port layout changes, then every lookup in either direction is a single
+    index in to a flat array, with no allocation. */
+class ChannelMap
+{
+public:
+    ChannelMap() { clearOffsets(); }
+
+    /** Build from a ChannelConfig, channels are in the order ports were added */
+    explicit ChannelMap (const ChannelConfig& config)
+    {
+        clearOffsets();
+        uint32 numPorts = 0;
+        for (int io = 0; io < 2; ++io)
+            for (int type = 0; type < PortType::Unknown; ++type)
+                for (const auto port : config.getChannelMapping (io == 0).getPorts (type))
+                    numPorts = jmax (numPorts, port + 1);
+
+        Array<PortType> types;
+        Array<bool> inputs;
+        types.insertMultiple (0, PortType::Unknown, (int) numPorts);
+        inputs.insertMultiple (0, false, (int) numPorts);
+        Array<int32> channels;
+        channels.insertMultiple (0, KV_INVALID_CHANNEL, (int) numPorts);
+
+        for (int io = 0; io < 2; ++io)
+        {
+            for (int type = 0; type < PortType::Unknown; ++type)
+            {
+                const Array<uint32>& ports = config.getChannelMapping (io == 0).getPorts (type);
+                for (int channel = 0; channel < ports.size(); ++channel)
+                {
+                    const int port = (int) ports.getUnchecked (channel);
+                    types.set (port, type);
+                    inputs.set (port, io == 0);
+                    channels.set (port, channel);
+                }
+            }
+        }
+
+        build (types, inputs, channels);
+    }
+
+    /** Build from a PortList, using the channels in its descriptions */
+    explicit ChannelMap (const PortList& list)
+    {
+        clearOffsets();
+        uint32 numPorts = 0;
+        for (const auto* port : list)
+            numPorts = jmax (numPorts, (uint32) port->index + 1);
+
+        Array<PortType> types;
+        Array<bool> inputs;
+        Array<int32> channels;
+        types.insertMultiple (0, PortType::Unknown, (int) numPorts);
+        inputs.insertMultiple (0, false, (int) numPorts);
+        channels.insertMultiple (0, KV_INVALID_CHANNEL, (int) numPorts);
+
+        for (const auto* port : list)
+        {
+            types.set (port->index, port->type);
+            inputs.set (port->index, port->input);
+            channels.set (port->index, port->channel);
+        }
+
+        build (types, inputs, channels);
+    }
+
+    /** Build from the type and direction of every port, sorted by port
+        index. Channels are numbered in port order per type and direction */
+    ChannelMap (const Array<PortType>& types, const Array<bool>& inputs)
+    {
+        jassert (types.size() == inputs.size());
+        clearOffsets();
+
+        int32 next [2][PortType::Unknown + 1] = {};
+        Array<int32> channels;
+        channels.ensureStorageAllocated (types.size());
+        for (int port = 0; port < types.size(); ++port)
+        {
+            const int type = types.getUnchecked (port);
+            channels.add (type == PortType::Unknown ? KV_INVALID_CHANNEL
+                                                    : next [inputs[port] ? 0 : 1][type]++);
+        }
+
+        build (types, inputs, channels);
+    }
+
+    /** Returns the number of ports, including any index that isn't mapped */
+    inline uint32 getNumPorts() const noexcept { return (uint32) info.size(); }
+
+    /** Returns the number of channels of a type and direction */
+    inline int32 getNumChannels (PortType type, bool isInput) const noexcept
+    {
+        if (type == PortType::Unknown)
+            return 0;
+        const int32* const o = offsets [isInput ? 0 : 1];
+        return o [type + 1] - o [type];
+    }
+
+    /** Returns the port for a channel, or KV_INVALID_PORT */
+    inline uint32 getPort (PortType type, int32 channel, bool isInput) const noexcept
+    {
+        return isPositiveAndBelow (channel, getNumChannels (type, isInput))
+            ? ports.getUnchecked (offsets [isInput ? 0 : 1][type] + channel)
+            : KV_INVALID_PORT;
+    }
+
+    /** Returns every port of a type and direction, in channel order */
+    inline const uint32* getPorts (PortType type, bool isInput) const noexcept
+    {
+        return ports.begin() + offsets [isInput ? 0 : 1][type];
+    }
+
+    /** Returns the channel of a port, or KV_INVALID_CHANNEL */
+    inline int32 getChannel (uint32 port) const noexcept
+    {
+        return port < getNumPorts() ? info.getReference ((int) port).channel : KV_INVALID_CHANNEL;
+    }
+
+    /** Returns the type of a port, or PortType::Unknown */
+    inline PortType getPortType (uint32 port) const noexcept
+    {
+        return port < getNumPorts() ? PortType ((int) info.getReference ((int) port).type) : PortType (PortType::Unknown);
+    }
+
+    /** Returns true if the port is an input */
+    inline bool isInput (uint32 port) const noexcept
+    {
+        return port < getNumPorts() && info.getReference ((int) port).input;
+    }
+
+    /** Swap contents with another map without allocating */
+    inline void swapWith (ChannelMap& other) noexcept
+    {
+        info.swapWith (other.info);
+        ports.swapWith (other.ports);
+        for (int io = 0; io < 2; ++io)
+            for (int type = 0; type <= PortType::Unknown; ++type)
+                std::swap (offsets [io][type], other.offsets [io][type]);
+    }
+
+private:
+    struct PortInfo
+    {
+        int32 channel;
+        uint8 type;
+        bool input;
+    };
+
+    Array<PortInfo> info;
+    Array<uint32> ports;    // channel -> port, grouped by direction then type
+    int32 offsets [2][PortType::Unknown + 1];
+
+    inline void clearOffsets()
+    {
+        for (auto& row : offsets)
+            for (auto& offset : row)
+                offset = 0;
+    }
+
+    inline void build (const Array<PortType>& types, const Array<bool>& inputs, const Array<int32>& channels)
+    {
+        // count channels per direction and type, then turn counts in to offsets
+        int32 counts [2][PortType::Unknown] = {};
+        for (int port = 0; port < types.size(); ++port)
+        {
+            const int type = types.getUnchecked (port);
+            if (type != PortType::Unknown)
+                counts [inputs[port] ? 0 : 1][type] = jmax (counts [inputs[port] ? 0 : 1][type], channels[port] + 1);
+        }
+
+        int32 total = 0;
+        for (int io = 0; io < 2; ++io)
+        {
+            for (int type = 0; type < PortType::Unknown; ++type)
+            {
+                offsets [io][type] = total;
+                total += counts [io][type];
+            }
+            offsets [io][PortType::Unknown] = total;
+        }
+
+        ports.insertMultiple (0, KV_INVALID_PORT, total);
+        info.ensureStorageAllocated (types.size());
+
+        for (int port = 0; port < types.size(); ++port)
+        {
+            const int type = types.getUnchecked (port);
+            const bool input = inputs[port];
+            PortInfo pi;
+            pi.type    = (uint8) type;
+            pi.input   = input;
+            pi.channel = type == PortType::Unknown ? KV_INVALID_CHANNEL : channels[port];
+            info.add (pi);
+
+            if (type != PortType::Unknown && channels[port] >= 0)
+                ports.set (offsets [input ? 0 : 1][type] + channels[port], (uint32) port);
+        }
+    }
+};
@@ -17,7 +17,7 @@
     Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 */
 RingBuffer::RingBuffer (int32 capacity)
-    : fifo (1), buffer (nullptr)
+    : fifo (1)
 {
     setCapacity (capacity);
 }
@@ -26,7 +26,6 @@ RingBuffer::~RingBuffer()
 {
     fifo.reset();
     fifo.setTotalSize (1);
-    buffer = nullptr;
     block.free();
 }
 
@@ -40,7 +39,6 @@ void RingBuffer::setCapacity (int32 newCapacity)
         newBlock.allocate (newCapacity, true);
         {
             block.swapWith (newBlock);
-            buffer = block.getData();
             fifo.setTotalSize (newCapacity);
         }
     }
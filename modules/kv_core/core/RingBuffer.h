@@ -51,7 +51,8 @@ public:
     inline uint32
     read (void* dest, uint32 size, bool advance = true)
     {
-        buffer = block.getData();
+        Vec vec1, vec2;
+        uint8* const buffer = block.getData();
         fifo.prepareToRead (size, vec1.index, vec1.size, vec2.index, vec2.size);
 
         if (vec1.size > 0)
@@ -72,14 +73,15 @@ public:
         return read (&dest, sizeof (T), advance);
     }
 
-    inline void advanceReadPointer (const uint32) {
-        jassertfalse;
+    inline void advanceReadPointer (const uint32 bytes) {
+        commitRead (bytes);
     }
 
     inline uint32
     write (const void* src, uint32 bytes)
     {
-        buffer = block.getData();
+        Vec vec1, vec2;
+        uint8* const buffer = block.getData();
         fifo.prepareToWrite (bytes, vec1.index, vec1.size, vec2.index, vec2.size);
 
         if (vec1.size > 0)
@@ -103,6 +105,55 @@ public:
         void*  buffer;
     };
 
+    /** Get the readable regions of the buffer without copying (reader thread).
+        The data may wrap around the end of the buffer, so two vectors are
+        filled. The second vector has a size of zero if the data is contiguous.
+        Call commitRead when done with the data.
+
+        @param vec  An array of two Vectors to fill
+        @returns    The total number of bytes readable */
+    inline uint32 getReadVector (Vector* vec) const
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+        vec[0].buffer = block.getData() + start1;
+        vec[0].size   = (uint32) size1;
+        vec[1].buffer = block.getData() + start2;
+        vec[1].size   = (uint32) size2;
+        return (uint32) (size1 + size2);
+    }
+
+    /** Get the writable regions of the buffer without copying (writer thread).
+        Serialize directly in to the returned vectors, then call commitWrite
+        with the number of bytes actually written.
+
+        @param vec  An array of two Vectors to fill
+        @returns    The total number of bytes writable */
+    inline uint32 getWriteVector (Vector* vec) const
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (fifo.getFreeSpace(), start1, size1, start2, size2);
+        vec[0].buffer = block.getData() + start1;
+        vec[0].size   = (uint32) size1;
+        vec[1].buffer = block.getData() + start2;
+        vec[1].size   = (uint32) size2;
+        return (uint32) (size1 + size2);
+    }
+
+    /** Mark bytes obtained from getReadVector as consumed */
+    inline void commitRead (uint32 bytes)
+    {
+        jassert (bytes <= getReadSpace());
+        fifo.finishedRead (static_cast<int> (bytes));
+    }
+
+    /** Mark bytes written in to getWriteVector as ready to be read */
+    inline void commitWrite (uint32 bytes)
+    {
+        jassert (bytes <= getWriteSpace());
+        fifo.finishedWrite (static_cast<int> (bytes));
+    }
+
 private:
     struct Vec
     {
@@ -110,8 +161,6 @@ private:
         int32 index;
     };
 
-    Vec vec1, vec2;
     AbstractFifo fifo;
     HeapBlock<uint8> block;
-    uint8* buffer;
 };
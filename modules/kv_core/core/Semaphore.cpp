@@ -34,9 +34,9 @@ Semaphore::~Semaphore()
     destroy();
 }
 
-bool Semaphore::init(unsigned /* initial */)
+bool Semaphore::init(unsigned initial)
 {
-    return semaphore_create(mach_task_self(), &semaphore, SYNC_POLICY_FIFO, 0)
+    return semaphore_create(mach_task_self(), &semaphore, SYNC_POLICY_FIFO, (int) initial)
         ? false : true;
 }
 
@@ -45,9 +45,10 @@ void Semaphore::destroy()
     semaphore_destroy(mach_task_self(), semaphore);
 }
 
-void Semaphore::post()
+void Semaphore::post (unsigned count)
 {
-    semaphore_signal(semaphore);
+    while (count-- > 0)
+        semaphore_signal(semaphore);
 }
 
 void Semaphore::wait()
@@ -55,6 +56,19 @@ void Semaphore::wait()
     semaphore_wait(semaphore);
 }
 
+bool Semaphore::timedWait (int milliseconds)
+{
+    if (milliseconds < 0)
+    {
+        wait();
+        return true;
+    }
+
+    const mach_timespec_t timeout = { (unsigned int) (milliseconds / 1000),
+                                      (clock_res_t) ((milliseconds % 1000) * 1000000) };
+    return semaphore_timedwait(semaphore, timeout) == KERN_SUCCESS;
+}
+
 bool
 Semaphore::tryWait()
 {
@@ -69,9 +83,14 @@ Semaphore::Semaphore()
     init (0);
 }
 
+Semaphore::Semaphore (unsigned initial)
+{
+    init (initial);
+}
+
 bool Semaphore::init(unsigned initial)
 {
-    semaphore = CreateSemaphore (NULL, initial, LONG_MAX, NULL);
+    semaphore = CreateSemaphore (NULL, (LONG) initial, LONG_MAX, NULL);
     return (semaphore) ? false : true;
 }
 
@@ -80,9 +99,9 @@ Semaphore::~Semaphore()
     CloseHandle(semaphore);
 }
 
-void Semaphore::post()
+void Semaphore::post (unsigned count)
 {
-    ReleaseSemaphore(semaphore, 1, NULL);
+    ReleaseSemaphore(semaphore, (LONG) count, NULL);
 }
 
 void Semaphore::wait()
@@ -90,12 +109,100 @@ void Semaphore::wait()
     WaitForSingleObject (semaphore, INFINITE);
 }
 
+bool Semaphore::timedWait (int milliseconds)
+{
+    return WAIT_OBJECT_0 == WaitForSingleObject (semaphore, milliseconds < 0 ? INFINITE
+                                                                             : (DWORD) milliseconds);
+}
+
 bool Semaphore::tryWait()
 {
-    return WAIT_FAILED != WaitForSingleObject (semaphore, 0);
+    return WAIT_OBJECT_0 == WaitForSingleObject (semaphore, 0);
 }
 
-#else  /* !defined(__APPLE__) && !defined(_WIN32) */
+#elif KV_SEMAPHORE_FUTEX
+
+Semaphore::Semaphore() { init (0); }
+
+Semaphore::Semaphore (unsigned initial)
+{
+    init (initial);
+}
+
+Semaphore::~Semaphore()
+{
+    destroy();
+}
+
+bool Semaphore::init (unsigned initial)
+{
+    value.store ((int32) initial);
+    waiters.store (0);
+    return true;
+}
+
+void Semaphore::destroy()
+{
+    jassert (waiters.load() == 0);
+}
+
+void Semaphore::post (unsigned count)
+{
+    if (count == 0)
+        return;
+
+    // value and waiters are both sequentially consistent, so either this
+    // sees the waiter or the waiter sees the new value before it parks
+    value.fetch_add ((int32) count);
+    if (waiters.load() > 0)
+        Futex::wake (value, (int32) jmin (count, (unsigned) std::numeric_limits<int32>::max()));
+}
+
+void Semaphore::wait()
+{
+    timedWait (-1);
+}
+
+bool Semaphore::timedWait (int milliseconds)
+{
+    if (tryWait())
+        return true;
+    if (milliseconds == 0)
+        return false;
+
+    const uint32 start = Time::getMillisecondCounter();
+    bool acquired = false;
+    ++waiters;
+
+    while (! (acquired = tryWait()))
+    {
+        int remaining = -1;
+        if (milliseconds > 0)
+        {
+            const uint32 elapsed = Time::getMillisecondCounter() - start;
+            if (elapsed >= (uint32) milliseconds)
+                break;
+            remaining = milliseconds - (int) elapsed;
+        }
+
+        // the kernel only parks if the value is still zero
+        Futex::wait (value, 0, remaining);
+    }
+
+    --waiters;
+    return acquired;
+}
+
+bool Semaphore::tryWait()
+{
+    int32 current = value.load();
+    while (current > 0)
+        if (value.compare_exchange_weak (current, current - 1))
+            return true;
+    return false;
+}
+
+#else  /* !defined(__APPLE__) && !defined(_WIN32) && !KV_SEMAPHORE_FUTEX */
 
 
 Semaphore::Semaphore() { init (0); }
@@ -117,9 +224,10 @@ Semaphore::~Semaphore()
     sem_destroy(&semaphore);
 }
 
-void Semaphore::post()
+void Semaphore::post (unsigned count)
 {
-    sem_post(&semaphore);
+    while (count-- > 0)
+        sem_post(&semaphore);
 }
 
 
@@ -132,6 +240,29 @@ void Semaphore::wait()
     while (sem_wait(&semaphore) != 0) {}
 }
 
+bool Semaphore::timedWait (int milliseconds)
+{
+    if (milliseconds < 0)
+    {
+        wait();
+        return true;
+    }
+
+    struct timespec deadline;
+    clock_gettime (CLOCK_REALTIME, &deadline);
+    deadline.tv_sec  += milliseconds / 1000;
+    deadline.tv_nsec += (milliseconds % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000)
+    {
+        deadline.tv_sec  += 1;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    int res;
+    while ((res = sem_timedwait(&semaphore, &deadline)) != 0 && errno == EINTR) {}
+    return res == 0;
+}
+
 bool Semaphore::tryWait()
 {
     return (sem_trywait(&semaphore) == 0);
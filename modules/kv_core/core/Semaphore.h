@@ -25,6 +25,8 @@
  typedef semaphore_t SemType;
 #elif defined(_WIN32)
  typedef void* SemType;
+#elif JUCE_LINUX
+ #define KV_SEMAPHORE_FUTEX 1
 #else
  #include <semaphore.h>
  typedef sem_t SemType;
@@ -46,6 +48,9 @@
    particular, at least on Linux, post is async-signal-safe, which means it
    does not block and will not be interrupted.  If you need to signal from
    a realtime thread, this is the most appropriate primitive to use.
+
+   On Linux the count lives in userspace and waiters park on a futex, so
+   post only makes a syscall when a thread is actually waiting.
 */
 
 struct Semaphore
@@ -62,18 +67,28 @@ bool init (unsigned initial);
 /** Destroy the semaphore */
 void destroy();
 
-/** Increment (and signal any waiters).
+/** Increment by count (and signal up to count waiters).
     Realtime safe. */
-void post();
+void post (unsigned count = 1);
 
 /** Wait until count is > 0 */
 void wait();
 
+/** Wait until count is > 0, or until the timeout passes.
+    @param milliseconds Time to wait, or -1 to wait forever
+    @return true if decrement was successful, false if it timed out. */
+bool timedWait (int milliseconds);
+
 /** Non-blocking version of wait().
     @return true if decrement was successful (lock was acquired). */
 bool tryWait();
 
 private:
+#if KV_SEMAPHORE_FUTEX
+  std::atomic<int32> value;
+  std::atomic<int32> waiters;
+#else
   SemType semaphore;
+#endif
 
 };
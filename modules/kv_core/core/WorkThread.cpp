@@ -30,9 +30,11 @@
 WorkThread::WorkThread (const String& name, uint32 bufsize, int32 priority)
     : Thread (name)
 {
-    nextWorkId = 0;
+    for (int i = 0; i < maxPages; ++i)
+        pages[i].store (nullptr);
+
     bufferSize = (uint32) nextPowerOfTwo (bufsize);
-    requests   = new RingBuffer (bufferSize);
+    requests   = new MultiProducerRingBuffer (bufferSize);
     startThread (priority);
 }
 
@@ -43,6 +45,15 @@ WorkThread::~WorkThread()
     sem.post();
     waitForThreadToExit (100);
     requests = nullptr;
+
+    for (int i = 0; i < maxPages; ++i)
+        delete[] pages[i].load();
+}
+
+WorkThread::Slot* WorkThread::getSlot (uint32 index) const
+{
+    Slot* const page = pages [(index / slotsPerPage) % maxPages].load (std::memory_order_acquire);
+    return page != nullptr ? page + (index % slotsPerPage) : nullptr;
 }
 
 WorkerBase* WorkThread::getWorker (uint32 workerId) const
@@ -50,24 +61,73 @@ WorkerBase* WorkThread::getWorker (uint32 workerId) const
     if (workerId == 0)
         return nullptr;
 
-    for (int i = 0; i < workers.size(); ++i)
-        if (workers.getUnchecked(i)->workId == workerId)
-            return workers.getUnchecked (i);
+    Slot* const slot = getSlot (workerId & 0xffff);
+    if (slot == nullptr || slot->id.load() != workerId)
+        return nullptr;
 
-    return nullptr;
+    return slot->worker.load();
 }
 
 void WorkThread::registerWorker (WorkerBase* worker)
 {
-    worker->workId = ++nextWorkId;
+    const ScopedLock sl (slotLock);
+
+    uint32 index;
+    if (freeSlots.size() > 0)
+    {
+        index = freeSlots.getLast();
+        freeSlots.removeLast();
+    }
+    else
+    {
+        // ids only have 16 bits for the slot, a worker past that stays
+        // unregistered with a zero id and scheduleWork() refuses it
+        if (numSlots >= (uint32) (slotsPerPage * maxPages))
+        {
+            worker->workId = 0;
+            return;
+        }
+
+        index = numSlots++;
+        if (index % slotsPerPage == 0)
+            pages [index / slotsPerPage].store (new Slot [slotsPerPage], std::memory_order_release);
+    }
+
+    Slot* const slot = getSlot (index);
+    if (++slot->generation == 0)
+        slot->generation = 1;
+
+    worker->workId = ((uint32) slot->generation << 16) | index;
+    slot->worker.store (worker);
+    slot->id.store (worker->workId);
+    ++numWorkers;
+
     KV_WORKER_LOG (getThreadName() + " registering worker: " + String (worker->workId));
-    workers.addIfNotAlreadyThere (worker);
 }
 
 void WorkThread::removeWorker (WorkerBase* worker)
 {
     KV_WORKER_LOG (getThreadName() + " removing worker: " + String (worker->workId));
-    workers.removeFirstMatchingValue (worker);
+    const uint32 workId = worker->workId;
+    if (workId == 0)
+        return;
+
+    Slot* const slot = getSlot (workId & 0xffff);
+    jassert (slot != nullptr && slot->worker.load() == worker);
+
+    // Invalidate the id first, then wait out a dispatch that may have looked
+    // it up just before. run() publishes the id it is about to dispatch, so
+    // one side always sees the other. The slot isn't reused until it is back
+    // on the free list, so waiting doesn't need the lock.
+    slot->id.store (0);
+    if (Thread::getCurrentThreadId() != getThreadId())
+        while (dispatchingId.load() == workId)
+            Thread::yield();
+
+    const ScopedLock sl (slotLock);
+    slot->worker.store (nullptr);
+    freeSlots.add (workId & 0xffff);
+    --numWorkers;
     worker->workId = 0;
 }
 
@@ -78,55 +138,49 @@ void WorkThread::run()
 
     while (true)
     {
-        sem.wait();
-        if (doExit || threadShouldExit()) 
+        // Writers post once per message, after it has been committed. Every
+        // committed message is drained on wake up, so a post for a message
+        // already handled here only makes the next wait return early. The
+        // wait is timed so exit is noticed even if a post never arrives.
+        sem.timedWait (exitCheckMs);
+        if (doExit.load() || threadShouldExit())
             break;
 
-        while (! validateMessage (*requests))
-            Thread::sleep (6);
-
-        if (doExit || threadShouldExit()) 
-            break;
-
-        uint32 size = 0;
-        if (requests->read (&size, sizeof (size)) < sizeof (size))
-        {
-            KV_WORKER_LOG ("error reading request: message size");
-            continue;
-        }
-
-        uint32 workId;
-        if (requests->read (&workId, sizeof (workId)) < sizeof (workId))
+        uint32 size = 0, workId = 0;
+        while (requests->peek (size, workId))
         {
-            KV_WORKER_LOG ("error reading request: worker id");
-            continue;
-        }
-
-        if (workId == 0)
-            continue;
+            if (workId == 0 || size == 0)
+            {
+                requests->finishedRead();
+                continue;
+            }
 
-        if (size > static_cast<uint32> (readBufferSize))
-        {
-			readBufferSize = nextPowerOfTwo (size);
-            buffer.realloc (readBufferSize);
-        }
+            if (size > static_cast<uint32> (readBufferSize))
+            {
+                readBufferSize = nextPowerOfTwo (size);
+                buffer.realloc (readBufferSize);
+            }
 
-        if (requests->read (buffer.getData(), size) < size)
-        {
-            KV_WORKER_LOG ("error reading request: message body");
-            continue;
-        }
+            if (requests->read (buffer.getData(), size) < size)
+            {
+                KV_WORKER_LOG ("error reading request: message body");
+                continue;
+            }
 
-        {
+            dispatchingId.store (workId);
             if (WorkerBase* const worker = getWorker (workId))
             {
                 while (! worker->flag.setWorking (true)) {}
                 worker->processRequest (size, buffer.getData());
                 while (! worker->flag.setWorking (false)) {}
             }
+            dispatchingId.store (0);
+
+            if (doExit.load() || threadShouldExit())
+                break;
         }
 
-        if (threadShouldExit() || doExit)
+        if (doExit.load() || threadShouldExit())
             break;
     }
 
@@ -136,44 +190,55 @@ void WorkThread::run()
 
 bool WorkThread::scheduleWork (WorkerBase* worker, uint32 size, const void* data)
 {
-    jassert (size > 0 && worker && worker->workId != 0);
-    if (! requests->canWrite (requiredSpace (size)))
-        return false;
-
-    if (requests->write (&size, sizeof(size)) < sizeof (uint32))
-        return false;
-
-    if (requests->write (&worker->workId, sizeof (worker->workId)) < sizeof (worker->workId))
-        return false;
-
-    if (requests->write (data, size) < size)
+    jassert (size > 0 && worker);
+    if (worker->workId == 0 || ! requests->write (worker->workId, data, size))
         return false;
 
     sem.post();
     return true;
 }
 
-bool WorkThread::validateMessage (RingBuffer& ring)
+WorkThreadPool::WorkThreadPool (const String& name, int numThreads, uint32 bufsize, int32 priority)
+{
+    jassert (numThreads > 0);
+    for (int i = 0; i < jmax (1, numThreads); ++i)
+        threads.add (new WorkThread (name + " " + String (i + 1), bufsize, priority));
+}
+
+WorkThreadPool::~WorkThreadPool()
+{
+    threads.clear();
+}
+
+WorkThread& WorkThreadPool::assignWorker (WorkerBase* worker)
 {
-    uint32 size = 0;
-    ring.peak (&size, sizeof (size));
-    return ring.canRead (requiredSpace (size));
+    ScopedLock sl (lock);
+    WorkThread* thread = threads.getUnchecked (0);
+    for (int i = 1; i < threads.size(); ++i)
+        if (threads.getUnchecked(i)->getNumWorkers() < thread->getNumWorkers())
+            thread = threads.getUnchecked (i);
+    thread->registerWorker (worker);
+    return *thread;
 }
 
 WorkerBase::WorkerBase (WorkThread& thread, uint32 bufsize)
     : owner (thread)
 {
     responses = new RingBuffer (bufsize);
-    response.calloc (bufsize);
+    response.calloc (responses->size());
     thread.registerWorker (this);
 }
 
-WorkerBase::~WorkerBase()
+WorkerBase::WorkerBase (WorkThreadPool& pool, uint32 bufsize)
+    : owner (pool.assignWorker (this))
 {
-    while (flag.isWorking()) {
-        Thread::sleep (100);
-    }
+    responses = new RingBuffer (bufsize);
+    response.calloc (responses->size());
+}
 
+WorkerBase::~WorkerBase()
+{
+    // waits for a request in progress to finish
     owner.removeWorker (this);
     responses = nullptr;
     response.free();
@@ -184,48 +249,108 @@ bool WorkerBase::scheduleWork (uint32 size, const void* data)
     return owner.scheduleWork (this, size, data);
 }
 
-bool WorkerBase::respondToWork (uint32 size, const void* data)
+/** Copy bytes out of a pair of ring buffer vectors, starting at offset */
+static void copyFromVectors (const RingBuffer::Vector* vec, uint32 offset, void* dest, uint32 size)
 {
-    if (! responses->canWrite (sizeof (size) + size))
-        return false;
+    uint8* out = static_cast<uint8*> (dest);
+    if (offset < vec[0].size)
+    {
+        const uint32 n = jmin (size, vec[0].size - offset);
+        memcpy (out, static_cast<const uint8*> (vec[0].buffer) + offset, n);
+        out += n; size -= n; offset = 0;
+    }
+    else
+    {
+        offset -= vec[0].size;
+    }
 
-    if (responses->write (&size, sizeof (size)) < sizeof (size))
-        return false;
+    if (size > 0)
+        memcpy (out, static_cast<const uint8*> (vec[1].buffer) + offset, size);
+}
+
+/** Copy bytes in to a pair of ring buffer vectors, starting at offset */
+static void copyToVectors (const RingBuffer::Vector* vec, uint32 offset, const void* src, uint32 size)
+{
+    const uint8* in = static_cast<const uint8*> (src);
+    if (offset < vec[0].size)
+    {
+        const uint32 n = jmin (size, vec[0].size - offset);
+        memcpy (static_cast<uint8*> (vec[0].buffer) + offset, in, n);
+        in += n; size -= n; offset = 0;
+    }
+    else
+    {
+        offset -= vec[0].size;
+    }
+
+    if (size > 0)
+        memcpy (static_cast<uint8*> (vec[1].buffer) + offset, in, size);
+}
 
-    if (responses->write (data, size) < size)
+bool WorkerBase::respondToWork (uint32 size, const void* data)
+{
+    // size and body are committed together so the realtime
+    // thread never sees half a response
+    RingBuffer::Vector vec[2];
+    if (responses->getWriteVector (vec) < sizeof (size) + size)
         return false;
 
+    copyToVectors (vec, 0, &size, sizeof (size));
+    copyToVectors (vec, sizeof (size), data, size);
+    responses->commitWrite (sizeof (size) + size);
     return true;
 }
 
-void WorkerBase::processWorkResponses()
+int WorkerBase::processWorkResponses (int maxResponses, uint32 maxBytes)
 {
-    uint32 remaining = responses->getReadSpace();
-    uint32 size      = 0;
+    RingBuffer::Vector vec[2];
+    const uint32 available = responses->getReadVector (vec);
+    uint32 offset = 0, bytes = 0;
+    int count = 0;
 
-    while (remaining >= sizeof (uint32))
+    while (available - offset >= sizeof (uint32))
     {
-        /* respond next cycle if response isn't ready */
-        if (! validateMessage (*responses))
-            return;
+        if (maxResponses > 0 && count >= maxResponses)
+            break;
+
+        uint32 size = 0;
+        copyFromVectors (vec, offset, &size, sizeof (size));
+        jassert (size <= available - offset - sizeof (uint32));
+        if (size > available - offset - sizeof (uint32))
+            break;
 
-        responses->read (&size, sizeof (size));
-        responses->read (response.getData(), size);
-        processResponse (size, response.getData());
-        remaining -= (sizeof (uint32) + size);
+        if (maxBytes > 0 && count > 0 && bytes + size > maxBytes)
+            break;
+
+        const uint32 body = offset + sizeof (uint32);
+        if (body + size <= vec[0].size)
+        {
+            processResponse (size, static_cast<const uint8*> (vec[0].buffer) + body);
+        }
+        else if (body >= vec[0].size)
+        {
+            processResponse (size, static_cast<const uint8*> (vec[1].buffer) + (body - vec[0].size));
+        }
+        else
+        {
+            // only a response that straddles the end of the ring is copied
+            copyFromVectors (vec, body, response.getData(), size);
+            processResponse (size, response.getData());
+        }
+
+        offset = body + size;
+        bytes += size;
+        ++count;
     }
-}
 
-bool WorkerBase::validateMessage (RingBuffer& ring)
-{
-    // the worker only validates message size
-    uint32 size = 0;
-    ring.peak (&size, sizeof(size));
-    return ring.canRead (size + sizeof(size));
+    if (offset > 0)
+        responses->commitRead (offset);
+
+    return count;
 }
 
 void WorkerBase::setSize (uint32 newSize)
 {
     responses = new RingBuffer (newSize);
-    response.realloc (newSize);
+    response.realloc (responses->size());
 }
@@ -20,6 +20,7 @@
 #pragma once
 
 class WorkerBase;
+class WorkThreadPool;
 
 /** A worker thread
     Capable of scheduling non-realtime work from a realtime context. */
@@ -29,41 +30,107 @@ public:
     WorkThread (const String& name, uint32 bufsize, int32 priority = 5);
     ~WorkThread();
 
-    inline static uint32 requiredSpace (uint32 msgSize) { return msgSize + (2 * sizeof (uint32)); }
+    inline static uint32 requiredSpace (uint32 msgSize) { return MultiProducerRingBuffer::requiredSpace (msgSize); }
+
+    /** Returns the number of workers registered with this thread */
+    inline int getNumWorkers() const { return numWorkers.load(); }
 
 protected:
     friend class WorkerBase;
+    friend class WorkThreadPool;
 
-    /** Register a worker for scheduling. Does not take ownership */
+    /** Register a worker for scheduling. Does not take ownership.
+        Safe to call while the thread is processing requests. A thread holds
+        at most 65536 workers; past that the worker is left unregistered and
+        its scheduleWork() calls return false */
     void registerWorker (WorkerBase* worker);
 
-    /** Deregister a worker from scheduling. Does not delete the worker */
+    /** Deregister a worker from scheduling. Does not delete the worker.
+        If the worker is processing a request this blocks until it is done,
+        and any of its requests still queued are dropped */
     void removeWorker (WorkerBase* worker);
 
     /** Schedule non-realtime work
-        Workers will call this in Worker::scheduleWork */
+        Workers will call this in Worker::scheduleWork. This is lock-free and
+        may be called from any number of threads at the same time.
+        @returns false if the queue is full or the worker isn't registered */
     bool scheduleWork (WorkerBase* worker, uint32 size, const void* data);
 
 private:
     uint32 bufferSize;
 
+    /** Worker ids are a slot index in the low 16 bits and the slot's
+        generation in the high 16 bits. Reusing a slot bumps the generation,
+        so requests queued for a removed worker can't reach its replacement. */
+    struct Slot
+    {
+        Slot() : id (0), worker (nullptr), generation (0) { }
+        std::atomic<uint32> id;
+        std::atomic<WorkerBase*> worker;
+        uint16 generation;
+    };
+
+    enum { slotsPerPage = 256, maxPages = 256, exitCheckMs = 100 };
+
+    /** Slots live in fixed pages that never move once published, so lookups
+        need neither a lock nor a search */
+    std::atomic<Slot*> pages [maxPages];
+    uint32 numSlots = 0;
+    Array<uint32> freeSlots;
+    CriticalSection slotLock;
+    std::atomic<int> numWorkers { 0 };
+    std::atomic<uint32> dispatchingId { 0 };
+
+    Slot* getSlot (uint32 index) const;
     WorkerBase* getWorker (uint32 workerId) const;
-    Array<WorkerBase*, CriticalSection> workers;
-
-    uint32 nextWorkId;
 
     Semaphore sem;
-    bool doExit = false;
-
-    ScopedPointer<RingBuffer> requests;  ///< requests to process
+    std::atomic<bool> doExit { false };
 
-    /** @internal Validate a ringbuffer for message completeness */
-    bool validateMessage (RingBuffer& ring);
+    ScopedPointer<MultiProducerRingBuffer> requests;  ///< requests to process
 
     /** @internal The work thread function */
     void run();
 };
 
+/** A group of WorkThreads sharing the non-realtime work load
+
+    Each worker is assigned to one thread of the pool when it is created and
+    stays there, so requests from a single worker are still processed in the
+    order they were scheduled. A slow worker only holds up the workers that
+    share its thread.
+
+    Workers must be deleted before the pool. */
+class WorkThreadPool
+{
+public:
+    /** Create a pool
+        @param name         Base name for the threads
+        @param numThreads   Number of threads to run
+        @param bufsize      Request buffer size for each thread
+        @param priority     Thread priority */
+    WorkThreadPool (const String& name, int numThreads, uint32 bufsize, int32 priority = 5);
+    ~WorkThreadPool();
+
+    /** Returns the number of threads in the pool */
+    inline int getNumThreads() const { return threads.size(); }
+
+    /** Returns a thread in the pool */
+    inline WorkThread* getThread (int index) const { return threads [index]; }
+
+private:
+    friend class WorkerBase;
+    OwnedArray<WorkThread> threads;
+    CriticalSection lock;
+
+    /** @internal Register a new worker with the least loaded thread. Picking
+        and registering share one lock, so workers created at the same time
+        spread out */
+    WorkThread& assignWorker (WorkerBase* worker);
+
+    JUCE_DECLARE_NON_COPYABLE (WorkThreadPool)
+};
+
 /** A flag that indicates whether work is happening or not */
 class WorkFlag
 {
@@ -84,6 +151,12 @@ public:
         @param thread The WorkThread to use when scheduling
         @param bufsize Size to use for internal response buffers */
     WorkerBase (WorkThread& thread, uint32 bufsize);
+
+    /** Create a new Worker on a thread pool
+        @param pool The pool to pick a WorkThread from
+        @param bufsize Size to use for internal response buffers */
+    WorkerBase (WorkThreadPool& pool, uint32 bufsize);
+
     virtual ~WorkerBase();
 
     /** Returns true if the worker is currently working */
@@ -101,10 +174,19 @@ public:
 
     /** Deliver pending responses (realtime thread)
         This must be called regularly from the realtime thread. For each read
-        response, Worker::processResponse will be called */
-    void processWorkResponses();
+        response, Worker::processResponse will be called. Responses are read
+        in place in one pass and nothing is allocated.
+
+        Pass a budget to spread a burst of responses over several cycles. At
+        least one pending response is always delivered.
 
-    /** Set the internal buffer size for responses */
+        @param maxResponses Maximum responses to deliver, or 0 for no limit
+        @param maxBytes     Maximum body bytes to deliver, or 0 for no limit
+        @returns            The number of responses delivered */
+    int processWorkResponses (int maxResponses = 0, uint32 maxBytes = 0);
+
+    /** Set the internal buffer size for responses. Not realtime safe, and
+        must not be called while responses are being written or read */
     void setSize (uint32 newSize);
 
 protected:
@@ -120,9 +202,7 @@ private:
     WorkFlag flag;                       ///< A flag for when work is being processed
 
     ScopedPointer<RingBuffer> responses; ///< responses from work
-    HeapBlock<uint8>          response;  ///< buffer to write a response
-
-    bool validateMessage (RingBuffer& ring);
+    HeapBlock<uint8>          response;  ///< scratch for responses that wrap the ring
 
     friend class WorkThread;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WorkerBase);
@@ -35,10 +35,28 @@
  #include <windows.h>
 #endif
 
+#include <cerrno>
+#include <ctime>
+
+#if JUCE_LINUX
+ #include <linux/futex.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#endif
+
+#if JUCE_INTEL
+ #include <emmintrin.h>
+#endif
+
 namespace kv {
  using namespace juce;
  #include "core/Arc.cpp"
+ #include "core/Atomic.cpp"
+ #include "core/GraphCompiler.cpp"
  #include "core/MatrixState.cpp"
+ #include "core/Monitor.cpp"
+ #include "core/MultiProducerRingBuffer.cpp"
+ #include "core/Parameter.cpp"
  #include "core/RingBuffer.cpp"
  #include "core/Semaphore.cpp"
  #include "core/WorkThread.cpp"
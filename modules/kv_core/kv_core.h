@@ -73,6 +73,7 @@ using namespace juce;
 #include "core/AudioRingBuffer.h"
 #include "core/Arc.h"
 #include "core/Atomic.h"
+#include "core/GraphCompiler.h"
 #include "core/LinkedList.h"
 #include "core/MatrixState.h"
 #include "core/MidiChannels.h"
@@ -81,6 +82,7 @@ using namespace juce;
 #include "core/Pointer.h"
 #include "core/PortType.h"
 #include "core/RingBuffer.h"
+#include "core/MultiProducerRingBuffer.h"
 #include "core/Semaphore.h"
 #include "core/Slugs.h"
 #include "core/Types.h"
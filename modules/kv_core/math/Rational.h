@@ -52,3 +52,53 @@ struct Rational
     /** Returns an inverted ratio (denominator / numerator) */
     double invertedRatio() const        { return inverted().ratio(); }
 };
+
+/** Returns round (a * b / c) with a 128 bit intermediate product, using only
+    64 bit arithmetic. mulDivRound uses this where __int128 isn't available,
+    e.g. MSVC */
+inline uint64 mulDivRoundPortable (uint64 a, uint64 b, uint64 c) noexcept
+{
+    jassert (c > 0);
+
+    // 64 x 64 -> 128 bit multiply from 32 bit halves
+    const uint64 aLo = a & 0xffffffff, aHi = a >> 32;
+    const uint64 bLo = b & 0xffffffff, bHi = b >> 32;
+    const uint64 ll = aLo * bLo, lh = aLo * bHi, hl = aHi * bLo, hh = aHi * bHi;
+    const uint64 middle = (ll >> 32) + (lh & 0xffffffff) + (hl & 0xffffffff);
+    uint64 lo = (ll & 0xffffffff) | (middle << 32);
+    uint64 hi = hh + (lh >> 32) + (hl >> 32) + (middle >> 32);
+
+    const uint64 half = c / 2;
+    lo += half;
+    if (lo < half)
+        ++hi;
+
+    // restoring division, one bit at a time
+    uint64 quotient = 0, remainder = 0;
+    for (int bit = 127; bit >= 0; --bit)
+    {
+        const bool carry = (remainder >> 63) != 0;
+        remainder = (remainder << 1) | ((bit >= 64 ? (hi >> (bit - 64)) : (lo >> bit)) & 1);
+        quotient <<= 1;
+        if (carry || remainder >= c)
+        {
+            remainder -= c;
+            quotient |= 1;
+        }
+    }
+
+    return quotient;
+}
+
+/** Returns round (a * b / c) with a 128 bit intermediate product. The
+    result must fit 64 bits */
+inline uint64 mulDivRound (uint64 a, uint64 b, uint64 c) noexcept
+{
+   #if defined (__SIZEOF_INT128__)
+    jassert (c > 0);
+    const unsigned __int128 product = (unsigned __int128) a * b + c / 2;
+    return (uint64) (product / c);
+   #else
+    return mulDivRoundPortable (a, b, c);
+   #endif
+}
@@ -17,17 +17,68 @@
     Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 */
 
+namespace TimeScaleHelpers {
+
+static uint64 greatestCommonDivisor (uint64 a, uint64 b) noexcept
+{
+    while (b != 0)
+    {
+        const uint64 t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/** Multiplies offsets by a ratio in double precision, rounding to nearest
+    even. Offsets and results must be within 2^51.
+
+    SSE2 and AVX2 can't convert between int64 and double, so the loop goes
+    through the 1.5 * 2^52 magic number instead: adding it to a small integer
+    in the bit domain gives the double magic + value, and adding it to a
+    double rounds it to an integer in the low mantissa bits. That leaves
+    integer and double adds, which GCC vectorises at -O3. */
+static void scaleOffsets (const uint64* source, uint64 sourceOrigin, uint64* dest,
+                          uint64 destOrigin, double ratio, int numValues) noexcept
+{
+    const double magic = 6755399441055744.0;
+    const int64 magicBits = 0x4338000000000000LL;
+
+    for (int i = 0; i < numValues; ++i)
+    {
+        const int64 in = (int64) (source[i] - sourceOrigin) + magicBits;
+        double offset;
+        memcpy (&offset, &in, sizeof (offset));
+
+        const double scaled = (offset - magic) * ratio + magic;
+        int64 out;
+        memcpy (&out, &scaled, sizeof (out));
+        dest[i] = destOrigin + (uint64) (out - magicBits);
+    }
+}
+
+}
+
+int64 TimeScale::scaleExact (int64 value, uint64 numerator, uint64 denominator) noexcept
+{
+    return value >= 0 ?  (int64) mulDivRound ((uint64) value, numerator, denominator)
+                      : -(int64) mulDivRound ((uint64) -value, numerator, denominator);
+}
+
 void TimeScale::reset()
 {
     mNodes.setScoped (true);
     mMarkers.setScoped (true);
+    mNodes.setIndexCached (true);
+    mMarkers.setIndexCached (true);
 
-	// Clear/reset location-markers...
-    mMarkers.clear();
+	// Clear/reset location-markers, keeping them for reuse...
+    mMarkers.removeAll();
     mMarkerCursor.reset();
 
 	// Clear/reset tempo-map...
-	mNodes.clear();
+    invalidateSegments (0);
+	mNodes.removeAll();
     mCursor.reset();
 
 	// There must always be one node, always.
@@ -48,6 +99,7 @@ void TimeScale::clear()
     mSampleRate     = 44100;
     mTicksPerBeat   = 960;
     mPixelsPerBeat  = 32;
+    mExactMode      = false;
 
 	// Clear/reset tempo-map...
 	reset();
@@ -59,24 +111,26 @@ void TimeScale::sync (const TimeScale& ts)
     mSampleRate     = ts.mSampleRate;
     mTicksPerBeat  = ts.mTicksPerBeat;
     mPixelsPerBeat = ts.mPixelsPerBeat;
+    mExactMode     = ts.mExactMode;
 
 	// Copy location markers...
-	mMarkers.clear();
+	mMarkers.removeAll();
     Marker *other_marker = ts.mMarkers.first();
     while (other_marker)
     {
-        mMarkers.append (new Marker (*other_marker));
+        mMarkers.append (mMarkers.create (*other_marker));
         other_marker = other_marker->next();
 	}
 
     mMarkerCursor.reset();
 
 	// Copy tempo-map nodes...
-	mNodes.clear();
+    invalidateSegments (0);
+	mNodes.removeAll();
     Node *other = ts.nodes().first();
     while (other)
     {
-        mNodes.append (new Node (this, other->frame,
+        mNodes.append (mNodes.create (this, other->frame,
                        other->tempo, other->beatType,
                        other->beatsPerBar, other->beatDivisor));
         other = other->next();
@@ -92,6 +146,8 @@ TimeScale& TimeScale::copyFrom (const TimeScale& ts)
     {
         mNodes.setScoped (true);
         mMarkers.setScoped (true);
+        mNodes.setIndexCached (true);
+        mMarkers.setIndexCached (true);
 
         mSampleRate     = ts.mSampleRate;
         mSnapPerBeat    = ts.mSnapPerBeat;
@@ -124,6 +180,44 @@ void TimeScale::Node::update()
         ticksPerBeat <<= n;
         beatRate /= float (1 << n);
 	}
+
+    // The same rates as exact fractions of a frame
+    const Rational exact (getExactTempo());
+    const uint64 framesPerMinute = (uint64) 60 * (uint64) ts->getSampleRate();
+    tickNum = (uint64) exact.numerator * (uint64) ts->ticksPerBeat();
+    tickDen = (uint64) exact.denominator * framesPerMinute;
+    beatNum = (uint64) exact.numerator;
+    beatDen = (uint64) exact.denominator * framesPerMinute;
+
+    if (beatDivisor > beatType)
+        beatNum <<= (beatDivisor - beatType);
+    else if (beatDivisor < beatType)
+        beatDen <<= (beatType - beatDivisor);
+
+    uint64 divisor = TimeScaleHelpers::greatestCommonDivisor (tickNum, tickDen);
+    tickNum /= divisor;
+    tickDen /= divisor;
+    divisor = TimeScaleHelpers::greatestCommonDivisor (beatNum, beatDen);
+    beatNum /= divisor;
+    beatDen /= divisor;
+}
+
+Rational TimeScale::Node::getExactTempo() const
+{
+    int exponent = 0;
+    const double fraction = std::frexp ((double) tempo, &exponent);
+    int mantissa = (int) std::ldexp (fraction, 24);
+    int shift = 24 - exponent;
+    jassert (tempo > 0.0f && shift >= 0 && shift < 31);
+    shift = jlimit (0, 30, shift);
+
+    while (shift > 0 && (mantissa & 1) == 0)
+    {
+        mantissa >>= 1;
+        --shift;
+    }
+
+    return Rational (mantissa, 1 << shift);
 }
 
 void TimeScale::Node::reset (TimeScale::Node *node)
@@ -171,11 +265,193 @@ uint64 TimeScale::Node::tickSnap (uint64 tick_, unsigned short p) const
     return tick + ticksnap;
 }
 
+void TimeScale::Node::getTickFrameRatio (uint64& numerator, uint64& denominator) const
+{
+    const Rational exact (getExactTempo());
+    numerator   = (uint64) exact.numerator * (uint64) ts->ticksPerBeat();
+    denominator = (uint64) exact.denominator * (uint64) 60 * (uint64) ts->getSampleRate();
+
+    const uint64 divisor = TimeScaleHelpers::greatestCommonDivisor (numerator, denominator);
+    if (divisor > 1)
+    {
+        numerator   /= divisor;
+        denominator /= divisor;
+    }
+}
+
+void TimeScale::Node::ticksFromFrames (const uint64* frames, uint64* ticks, int numValues, Precision precision) const
+{
+    if (precision == RationalPrecision)
+    {
+        uint64 num, den;
+        getTickFrameRatio (num, den);
+        for (int i = 0; i < numValues; ++i)
+            ticks[i] = frames[i] >= frame ? tick + mulDivRound (frames[i] - frame, num, den)
+                                          : tick - mulDivRound (frame - frames[i], num, den);
+    }
+    else
+    {
+        const double ratio = ((double) tempo * (double) ts->ticksPerBeat()) / (60.0 * (double) ts->getSampleRate());
+        TimeScaleHelpers::scaleOffsets (frames, frame, ticks, tick, ratio, numValues);
+    }
+}
+
+void TimeScale::Node::framesFromTicks (const uint64* ticks, uint64* frames, int numValues, Precision precision) const
+{
+    if (precision == RationalPrecision)
+    {
+        uint64 num, den;
+        getTickFrameRatio (num, den);
+        for (int i = 0; i < numValues; ++i)
+            frames[i] = ticks[i] >= tick ? frame + mulDivRound (ticks[i] - tick, den, num)
+                                         : frame - mulDivRound (tick - ticks[i], den, num);
+    }
+    else
+    {
+        const double ratio = (60.0 * (double) ts->getSampleRate()) / ((double) tempo * (double) ts->ticksPerBeat());
+        TimeScaleHelpers::scaleOffsets (ticks, tick, frames, frame, ratio, numValues);
+    }
+}
+
 void TimeScale::Cursor::reset (TimeScale::Node *n)
 {
     node = (n ? n : ts->nodes().first());
 }
 
+void TimeScale::invalidateSegments (TimeScale::Node* from)
+{
+    // The first indexed node at or before 'from' bounds what is still valid
+    for (Node* n = from; n != 0; n = n->prev())
+    {
+        if (isPositiveAndBelow (n->segment, mNumValidSegments)
+            && mSegments.getReference (n->segment).node == n)
+        {
+            mNumValidSegments = (n == from) ? n->segment : n->segment + 1;
+            mGridValid = false;
+            return;
+        }
+    }
+
+    mNumValidSegments = 0;
+    mGridValid = false;
+}
+
+TimeScale::Segment TimeScale::segmentFor (TimeScale::Node* node) noexcept
+{
+    Segment seg;
+    seg.frame = node->frame;
+    seg.tick  = node->tick;
+    seg.beat  = node->beat;
+    seg.pixel = node->pixel;
+    seg.bar   = node->bar;
+    seg.node  = node;
+    return seg;
+}
+
+void TimeScale::rebuildSegments()
+{
+    mSegments.removeRange (mNumValidSegments, mSegments.size() - mNumValidSegments);
+    mSegments.ensureStorageAllocated (mNodes.count());
+
+    Node* node = mNumValidSegments > 0 ? mSegments.getReference (mNumValidSegments - 1).node->next()
+                                       : mNodes.first();
+    for (; node != 0; node = node->next())
+    {
+        node->segment = mSegments.size();
+        mSegments.add (segmentFor (node));
+    }
+
+    mNumValidSegments = mSegments.size();
+}
+
+template<typename KeyType>
+TimeScale::Node* TimeScale::findSegment (KeyType Segment::* key, KeyType value) const
+{
+    // last valid segment with a key at or before value, or the first one
+    int lo = 0, hi = mNumValidSegments;
+    while (lo < hi)
+    {
+        const int mid = lo + (hi - lo) / 2;
+        if (mSegments.getReference (mid).*key <= value)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    Node* node = lo > 0 ? mSegments.getReference (lo - 1).node : mNodes.first();
+    if (node == 0 || lo < mNumValidSegments)
+        return node;
+
+    // only reached while an edit is re-positioning the nodes
+    for (Node* next = node->next(); next != 0 && segmentFor (next).*key <= value; next = next->next())
+        node = next;
+
+    return node;
+}
+
+const Array<TimeScale::GridLine>& TimeScale::getGridLines (int startPixel, int endPixel, int minSpacing) const
+{
+    startPixel = jmax (0, startPixel);
+    endPixel   = jmax (startPixel, endPixel);
+
+    if (mGridValid && mGridPixelRate == mPixelRate && mGridSnap == mSnapPerBeat && mGridSpacing == minSpacing
+        && mGridRange.contains (Range<int> (startPixel, endPixel)))
+        return mGridLines;
+
+    // a screen either side, so short scrolls reuse the lines
+    const int margin = endPixel - startPixel;
+    mGridRange     = Range<int> (jmax (0, startPixel - margin), endPixel + margin);
+    mGridPixelRate = mPixelRate;
+    mGridSnap      = mSnapPerBeat;
+    mGridSpacing   = minSpacing;
+    mGridValid     = true;
+    mGridLines.clearQuick();
+
+    for (Node* node = findSegment (&Segment::pixel, mGridRange.getStart()); node != 0; node = node->next())
+    {
+        if (node->pixel > mGridRange.getEnd())
+            break;
+
+        const uint64 beatTicks = jmax ((uint64) 1, (uint64) node->ticksPerBeat);
+        const double pixelsPerTick = (double) mPixelRate / (double) node->tickRate;
+        uint64 step = (mSnapPerBeat > 0) ? jmax ((uint64) 1, beatTicks / mSnapPerBeat) : beatTicks;
+
+        // thin out lines too close to see: snaps, then beats, then bars
+        if (step < beatTicks && pixelsPerTick * (double) step < (double) minSpacing)
+            step = beatTicks;
+        if (pixelsPerTick > 0.0 && pixelsPerTick * (double) step < (double) minSpacing)
+        {
+            step = beatTicks * jmax ((uint64) 1, (uint64) node->beatsPerBar);
+            while (pixelsPerTick * (double) step < (double) minSpacing)
+                step *= 2;
+        }
+        const uint64 endTick = (node->next() != 0) ? node->next()->tick : std::numeric_limits<uint64>::max();
+
+        // first step at or after the range start, counted from the node
+        const int fromPixel = jmax (node->pixel, mGridRange.getStart());
+        uint64 offset = node->tickFromPixel (fromPixel) - node->tick;
+        offset = step * ((offset + step - 1) / step);
+
+        for (uint64 tick = node->tick + offset; tick < endTick; tick += step)
+        {
+            const int pixel = node->pixelFromTick (tick);
+            if (pixel > mGridRange.getEnd())
+                break;
+            if (pixel < mGridRange.getStart())
+                continue;
+
+            GridLine line;
+            line.pixel  = pixel;
+            line.beat   = node->beatFromTick (tick);
+            line.isBeat = ((tick - node->tick) % beatTicks) == 0;
+            line.isBar  = line.isBeat && node->beatIsBar (line.beat);
+            mGridLines.add (line);
+        }
+    }
+
+    return mGridLines;
+}
+
 TimeScale::Node* TimeScale::Cursor::seekFrame (uint64 iFrame) const
 {
     if (node == 0)
@@ -185,21 +461,12 @@ TimeScale::Node* TimeScale::Cursor::seekFrame (uint64 iFrame) const
 			return 0;
 	}
 
-    if (iFrame > node->frame)
-    {
-		// Seek frame forward...
-		while (node && node->next() && iFrame >= (node->next())->frame)
-			node = node->next();
-	}
-    else if (iFrame < node->frame)
-    {
-		// Seek frame backward...
-		while (node && node->frame > iFrame)
-			node = node->prev();
-		if (node == 0)
-			node = ts->nodes().first();
-	}
+    // Playback seeks land on the same or next node, anything else is a
+    // binary search of the segment index.
+    if (iFrame >= node->frame && (node->next() == 0 || iFrame < node->next()->frame))
+        return node;
 
+    node = ts->findSegment (&Segment::frame, iFrame);
 	return node;
 }
 
@@ -212,21 +479,10 @@ TimeScale::Node* TimeScale::Cursor::seekBar (unsigned short sbar) const
 			return 0;
 	}
 
-    if (sbar > node->bar)
-    {
-		// Seek bar forward...
-        while (node && node->next() && sbar >= (node->next())->bar)
-			node = node->next();
-	}
-    else if (sbar < node->bar)
-    {
-		// Seek bar backward...
-        while (node && node->bar > sbar)
-			node = node->prev();
-		if (node == 0)
-			node = ts->nodes().first();
-	}
+    if (sbar >= node->bar && (node->next() == 0 || sbar < node->next()->bar))
+        return node;
 
+    node = ts->findSegment (&Segment::bar, sbar);
 	return node;
 }
 
@@ -238,20 +494,10 @@ TimeScale::Node* TimeScale::Cursor::seekBeat (unsigned int sbeat) const
 			return 0;
 	}
 
-    if (sbeat > node->beat) {
-		// Seek beat forward...
-        while (node && node->next() && sbeat >= (node->next())->beat)
-			node = node->next();
-	}
-	else
-    if (sbeat < node->beat) {
-		// Seek beat backward...
-        while (node && node->beat > sbeat)
-			node = node->prev();
-		if (node == 0)
-			node = ts->nodes().first();
-	}
+    if (sbeat >= node->beat && (node->next() == 0 || sbeat < node->next()->beat))
+        return node;
 
+    node = ts->findSegment (&Segment::beat, sbeat);
 	return node;
 }
 
@@ -264,21 +510,10 @@ TimeScale::Node* TimeScale::Cursor::seekTick (uint64 stick) const
 			return 0;
 	}
 
-    if (stick > node->tick)
-    {
-		// Seek tick forward...
-        while (node && node->next() && stick >= (node->next())->tick)
-			node = node->next();
-	}
-    else if (stick < node->tick)
-    {
-		// Seek tick backward...
-        while (node && node->tick > stick)
-			node = node->prev();
-		if (node == 0)
-			node = ts->nodes().first();
-	}
+    if (stick >= node->tick && (node->next() == 0 || stick < node->next()->tick))
+        return node;
 
+    node = ts->findSegment (&Segment::tick, stick);
 	return node;
 }
 
@@ -290,21 +525,10 @@ TimeScale::Node* TimeScale::Cursor::seekPixel (int px) const
 			return 0;
 	}
 
-    if (px > node->pixel)
-    {
-		// Seek pixel forward...
-        while (node && node->next() && px >= (node->next())->pixel)
-			node = node->next();
-	}
-    else if (px < node->pixel)
-    {
-		// Seek tick backward...
-        while (node && node->pixel > px)
-			node = node->prev();
-		if (node == 0)
-			node = ts->nodes().first();
-	}
+    if (px >= node->pixel && (node->next() == 0 || px < node->next()->pixel))
+        return node;
 
+    node = ts->findSegment (&Segment::pixel, px);
 	return node;
 }
 
@@ -354,7 +578,7 @@ TimeScale::Node* TimeScale::addNode (uint64 frame_, float tempo_, unsigned short
     else
     {
 		// Add/insert a new node...
-        node = new Node (this, frame_, tempo_, beat_type_, beats_per_bar_, beat_divisor_);
+        node = mNodes.create (this, frame_, tempo_, beat_type_, beats_per_bar_, beat_divisor_);
         if (prev)
             mNodes.insertAfter (node, prev);
 		else
@@ -372,6 +596,9 @@ void TimeScale::updateNode (TimeScale::Node *node)
 	// Update coefficients...
     node->update();
 
+	// Keys change from here on...
+    invalidateSegments (node);
+
 	// Relocate internal cursor...
     mCursor.reset (node);
 
@@ -389,6 +616,7 @@ void TimeScale::updateNode (TimeScale::Node *node)
 
 	// And update marker/bar positions too...
     updateMarkers (node->prev());
+    rebuildSegments();
 }
 
 
@@ -401,6 +629,7 @@ void TimeScale::removeNode (TimeScale::Node *node)
 
 	// Relocate internal cursor...
     mCursor.reset(node_prev);
+    invalidateSegments (node);
 
 	// Update positioning on all nodes thereafter...
     Node *prev = node_prev;
@@ -419,6 +648,7 @@ void TimeScale::removeNode (TimeScale::Node *node)
 
 	// Then update marker/bar positions too...
     updateMarkers (prev);
+    rebuildSegments();
 }
 
 void TimeScale::updateScale()
@@ -426,6 +656,7 @@ void TimeScale::updateScale()
 	// Update time-map independent coefficients...
     mPixelRate = 1.20f * float (mHorizontalZoom * mPixelsPerBeat);
     mFrameRate = 60.0f * float (mSampleRate);
+    invalidateSegments (0);
 
 	// Update all nodes thereafter...
     Node *prev = 0;
@@ -442,6 +673,50 @@ void TimeScale::updateScale()
 
 	// Also update all marker/bar positions too...
     updateMarkers (mNodes.first());
+    rebuildSegments();
+}
+
+void TimeScale::ticksFromFrames (const uint64* frames, uint64* ticks, int numValues, Precision precision) const
+{
+    for (int start = 0; start < numValues;)
+    {
+        const Node* const node = mCursor.seekFrame (frames[start]);
+        if (node == 0)
+        {
+            zeromem (ticks + start, sizeof (uint64) * (size_t) (numValues - start));
+            return;
+        }
+
+        // extend the run while values stay in this node's segment
+        const Node* const next = node->next();
+        int end = start + 1;
+        while (end < numValues && frames[end] >= node->frame && (next == 0 || frames[end] < next->frame))
+            ++end;
+
+        node->ticksFromFrames (frames + start, ticks + start, end - start, precision);
+        start = end;
+    }
+}
+
+void TimeScale::framesFromTicks (const uint64* ticks, uint64* frames, int numValues, Precision precision) const
+{
+    for (int start = 0; start < numValues;)
+    {
+        const Node* const node = mCursor.seekTick (ticks[start]);
+        if (node == 0)
+        {
+            zeromem (frames + start, sizeof (uint64) * (size_t) (numValues - start));
+            return;
+        }
+
+        const Node* const next = node->next();
+        int end = start + 1;
+        while (end < numValues && ticks[end] >= node->tick && (next == 0 || ticks[end] < next->tick))
+            ++end;
+
+        node->framesFromTicks (ticks + start, frames + start, end - start, precision);
+        start = end;
+    }
 }
 
 // Beat divisor (snap index) map.
@@ -574,7 +849,7 @@ TimeScale::Marker* TimeScale::addMarker (uint64 target_frame, const std::string&
     else
     {
 		// Add/insert a new marker...
-        marker = new Marker(target_frame, nearest_bar, txt, rgb);
+        marker = mMarkers.create (target_frame, nearest_bar, txt, rgb);
 
         if (nearest_marker && nearest_marker->frame > target_frame)
             mMarkers.insertBefore (marker, nearest_marker);
@@ -626,3 +901,185 @@ void TimeScale::updateMarkers (TimeScale::Node *pNode)
 		pMarker = pMarker->next();
 	}
 }
+
+TimeScaleSnapshot::TimeScaleSnapshot (const TimeScale& ts)
+    : frameRate (ts.frameRate()), pixelRate (ts.pixelRate()),
+      sampleRate (ts.getSampleRate()), ticksPerBeatResolution (ts.ticksPerBeat()),
+      exactMode (ts.isExactMode())
+{
+    segments.ensureStorageAllocated (ts.nodes().count());
+    for (const TimeScale::Node* node = ts.nodes().first(); node != nullptr; node = node->next())
+    {
+        Segment seg;
+        seg.frame        = node->frame;
+        seg.tick         = node->tick;
+        seg.beat         = node->beat;
+        seg.pixel        = node->pixel;
+        seg.bar          = node->bar;
+        seg.tempo        = node->tempo;
+        seg.beatsPerBar  = node->beatsPerBar;
+        seg.ticksPerBeat = node->ticksPerBeat;
+        seg.tickRate     = node->tickRate;
+        seg.beatRate     = node->beatRate;
+        seg.tickNum      = node->tickNum;
+        seg.tickDen      = node->tickDen;
+        seg.beatNum      = node->beatNum;
+        seg.beatDen      = node->beatDen;
+        segments.add (seg);
+    }
+
+    // There must always be one segment, like there is always one node
+    if (segments.size() <= 0)
+    {
+        Segment seg;
+        zerostruct (seg);
+        seg.tempo        = 120.0f;
+        seg.beatsPerBar  = 4;
+        seg.ticksPerBeat = ticksPerBeatResolution;
+        seg.tickRate     = seg.tempo * (float) ticksPerBeatResolution;
+        seg.beatRate     = seg.tempo;
+        seg.tickNum      = (uint64) 2 * ticksPerBeatResolution;
+        seg.tickDen      = jmax ((uint64) 1, (uint64) sampleRate);
+        seg.beatNum      = 2;
+        seg.beatDen      = seg.tickDen;
+        segments.add (seg);
+    }
+}
+
+template<typename KeyType>
+const TimeScaleSnapshot::Segment& TimeScaleSnapshot::seek (KeyType Segment::* key, KeyType value, Cursor& cursor) const noexcept
+{
+    const Segment* const segs = segments.begin();
+    const int numSegments = segments.size();
+
+    // the cursor may come from a different snapshot
+    int index = isPositiveAndBelow (cursor.segment, numSegments) ? cursor.segment : 0;
+    if (value >= segs[index].*key && (index + 1 == numSegments || value < segs[index + 1].*key))
+        return segs[index];
+
+    int lo = 0, hi = numSegments;
+    while (lo < hi)
+    {
+        const int mid = lo + (hi - lo) / 2;
+        if (segs[mid].*key <= value)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    cursor.segment = index = (lo > 0 ? lo - 1 : 0);
+    return segs[index];
+}
+
+uint64 TimeScaleSnapshot::tickFromFrame (uint64 iFrame, Cursor& cursor) const noexcept
+{
+    const Segment& s = seek (&Segment::frame, iFrame, cursor);
+    if (exactMode)
+        return s.tick + (uint64) TimeScale::scaleExact ((int64) (iFrame - s.frame), s.tickNum, s.tickDen);
+    return s.tick + (uint64) TimeScale::uroundf ((s.tickRate * (iFrame - s.frame)) / frameRate);
+}
+
+uint64 TimeScaleSnapshot::frameFromTick (uint64 iTick, Cursor& cursor) const noexcept
+{
+    const Segment& s = seek (&Segment::tick, iTick, cursor);
+    if (exactMode)
+        return s.frame + (uint64) TimeScale::scaleExact ((int64) (iTick - s.tick), s.tickDen, s.tickNum);
+    return s.frame + (uint64) TimeScale::uroundf ((frameRate * (iTick - s.tick)) / s.tickRate);
+}
+
+void TimeScaleSnapshot::framesFromTicks (const uint64* ticks, uint64* frames, int numValues, Cursor& cursor) const noexcept
+{
+    for (int start = 0; start < numValues;)
+    {
+        const Segment& s = seek (&Segment::tick, ticks[start], cursor);
+        const Segment* const next = (&s + 1 < segments.end()) ? &s + 1 : nullptr;
+        int end = start + 1;
+        while (end < numValues && ticks[end] >= s.tick && (next == nullptr || ticks[end] < next->tick))
+            ++end;
+
+        if (exactMode)
+        {
+            for (int i = start; i < end; ++i)
+                frames[i] = s.frame + (uint64) TimeScale::scaleExact ((int64) (ticks[i] - s.tick), s.tickDen, s.tickNum);
+        }
+        else
+        {
+            for (int i = start; i < end; ++i)
+                frames[i] = s.frame + (uint64) TimeScale::uroundf ((frameRate * (ticks[i] - s.tick)) / s.tickRate);
+        }
+
+        start = end;
+    }
+}
+
+unsigned int TimeScaleSnapshot::beatFromFrame (uint64 iFrame, Cursor& cursor) const noexcept
+{
+    const Segment& s = seek (&Segment::frame, iFrame, cursor);
+    if (exactMode)
+        return s.beat + (unsigned int) TimeScale::scaleExact ((int64) (iFrame - s.frame), s.beatNum, s.beatDen);
+    return s.beat + (unsigned int) TimeScale::uroundf ((s.beatRate * (iFrame - s.frame)) / frameRate);
+}
+
+uint64 TimeScaleSnapshot::frameFromBeat (unsigned int iBeat, Cursor& cursor) const noexcept
+{
+    const Segment& s = seek (&Segment::beat, iBeat, cursor);
+    if (exactMode)
+        return s.frame + (uint64) TimeScale::scaleExact ((int64) iBeat - (int64) s.beat, s.beatDen, s.beatNum);
+    return s.frame + (uint64) TimeScale::uroundf ((frameRate * (iBeat - s.beat)) / s.beatRate);
+}
+
+unsigned short TimeScaleSnapshot::barFromFrame (uint64 iFrame, Cursor& cursor) const noexcept
+{
+    const Segment& s = seek (&Segment::frame, iFrame, cursor);
+    if (exactMode)
+        return s.bar + (unsigned short) TimeScale::scaleExact ((int64) (iFrame - s.frame), s.beatNum, s.beatDen * s.beatsPerBar);
+    return s.bar + (unsigned short) TimeScale::uroundf (
+        (s.beatRate * (iFrame - s.frame)) / (frameRate * s.beatsPerBar));
+}
+
+uint64 TimeScaleSnapshot::frameFromBar (unsigned short iBar, Cursor& cursor) const noexcept
+{
+    const Segment& s = seek (&Segment::bar, iBar, cursor);
+    if (exactMode)
+        return s.frame + (uint64) TimeScale::scaleExact ((int64) s.beatsPerBar * ((int) iBar - (int) s.bar), s.beatDen, s.beatNum);
+    return s.frame + (uint64) TimeScale::uroundf (
+        (frameRate * s.beatsPerBar * (iBar - s.bar)) / s.beatRate);
+}
+
+int TimeScaleSnapshot::pixelFromTick (uint64 iTick, Cursor& cursor) const noexcept
+{
+    const Segment& s = seek (&Segment::tick, iTick, cursor);
+    return s.pixel + (int) TimeScale::uroundf ((pixelRate * (iTick - s.tick)) / s.tickRate);
+}
+
+uint64 TimeScaleSnapshot::tickFromPixel (int x, Cursor& cursor) const noexcept
+{
+    const Segment& s = seek (&Segment::pixel, x, cursor);
+    return s.tick + (uint64) TimeScale::uroundf ((s.tickRate * (x - s.pixel)) / pixelRate);
+}
+
+float TimeScaleSnapshot::getTempoAtFrame (uint64 iFrame, Cursor& cursor) const noexcept
+{
+    return seek (&Segment::frame, iFrame, cursor).tempo;
+}
+
+unsigned short TimeScaleSnapshot::getBeatsPerBarAtFrame (uint64 iFrame, Cursor& cursor) const noexcept
+{
+    return seek (&Segment::frame, iFrame, cursor).beatsPerBar;
+}
+
+void RealtimeTimeScale::publish (const TimeScale& ts)
+{
+    publish (new TimeScaleSnapshot (ts));
+}
+
+void RealtimeTimeScale::publish (TimeScaleSnapshot* snapshot)
+{
+    jassert (snapshot != nullptr);
+    latest = snapshot;
+
+    // The back slot is never seen by the reader, so whatever it held is
+    // released here on the editing thread.
+    slots [back] = snapshot;
+    back = middle.exchange (back | newFlag, std::memory_order_acq_rel) & indexMask;
+}
@@ -37,8 +37,15 @@ public:
         BBT
     };
 
-    TimeScale() : mDisplayFmt (Frames), mCursor (this), mMarkerCursor (this) { clear(); }
-    TimeScale (const TimeScale& ts) : mCursor (this), mMarkerCursor (this) { copyFrom (ts); }
+    /** Arithmetic used by the batch convertors */
+    enum Precision
+    {
+        DoublePrecision = 0,    ///< double math, offsets within 2^51
+        RationalPrecision       ///< exact 64 bit integer rational math
+    };
+
+    TimeScale() : mDisplayFmt (Frames), mCursor (this), mNumValidSegments (0), mGridValid (false), mMarkerCursor (this) { clear(); }
+    TimeScale (const TimeScale& ts) : mCursor (this), mNumValidSegments (0), mGridValid (false), mMarkerCursor (this) { copyFrom (ts); }
     TimeScale& operator=(const TimeScale& ts) { return copyFrom (ts); }
 
     /** Reset the node list */
@@ -55,6 +62,18 @@ public:
         @note Also calls sync */
     TimeScale& copyFrom (const TimeScale& ts);
 
+    /** Exact mode keeps node positions and frame conversions in exact
+        integer rational arithmetic, so long timelines don't drift. Call
+        updateScale after changing it. Bars are still counted in an
+        unsigned short, so a map must stay under 65536 bars, e.g. a day
+        at 179 bpm only fits with 4 or more beats a bar */
+    void setExactMode (bool exact) { mExactMode = exact; }
+    bool isExactMode() const { return mExactMode; }
+
+    /** Returns round (value * numerator / denominator) through a 128 bit
+        product. value may be negative */
+    static int64 scaleExact (int64 value, uint64 numerator, uint64 denominator) noexcept;
+
     /** Sample rate (frames per second) */
     void setSampleRate (unsigned int rate) { mSampleRate = rate; }
     unsigned int getSampleRate() const { return mSampleRate; }
@@ -102,7 +121,9 @@ public:
               tempo (tempo_), beatType (beattype_),
               beatsPerBar (beats_per_bar_), beatDivisor (beat_divisor_),
               ticksPerBeat (0), ts (timescale),
-              tickRate (1.0f), beatRate (1.0f)
+              tickRate (1.0f), beatRate (1.0f),
+              tickNum (1), tickDen (1), beatNum (1), beatDen (1),
+              segment (-1)
         { }
 
 		// Update node scale coefficients.
@@ -118,12 +139,16 @@ public:
 		// Frame/bar convertors.
         unsigned short barFromFrame (uint64 iFrame) const
         {
+            if (ts->isExactMode())
+                return bar + (unsigned short) scaleExact ((int64) (iFrame - frame), beatNum, beatDen * beatsPerBar);
             return bar + (unsigned short) uroundf (
                 (beatRate * (iFrame - frame)) / (ts->frameRate() * beatsPerBar));
         }
         
         uint64 frameFromBar (unsigned short iBar) const
         {
+            if (ts->isExactMode())
+                return frame + (uint64) scaleExact ((int64) beatsPerBar * ((int) iBar - (int) bar), beatDen, beatNum);
             return frame + (uint64) uroundf (
                 (ts->frameRate() * beatsPerBar * (iBar - bar)) / beatRate);
         }
@@ -131,18 +156,43 @@ public:
 		// Frame/beat convertors.
         unsigned int beatFromFrame (uint64 iFrame) const
         {
+            if (ts->isExactMode())
+                return beat + (unsigned int) scaleExact ((int64) (iFrame - frame), beatNum, beatDen);
             return beat + (unsigned int) uroundf ((beatRate * (iFrame - frame)) / ts->frameRate());
         }
         
-        uint64 frameFromBeat (unsigned int iBeat) const { return frame + (uint64) uroundf ((ts->frameRate() * (iBeat - beat)) / beatRate); }
+        uint64 frameFromBeat (unsigned int iBeat) const
+        {
+            if (ts->isExactMode())
+                return frame + (uint64) scaleExact ((int64) iBeat - (int64) beat, beatDen, beatNum);
+            return frame + (uint64) uroundf ((ts->frameRate() * (iBeat - beat)) / beatRate);
+        }
 
 		// Frame/tick convertors.
         uint64 tickFromFrame (uint64 iFrame) const
         {
+            if (ts->isExactMode())
+                return tick + (uint64) scaleExact ((int64) (iFrame - frame), tickNum, tickDen);
             return tick + (uint64) uroundf ((tickRate * (iFrame - frame)) / ts->frameRate());
         }
 		
-        uint64 frameFromTick(uint64 iTick) const { return frame + (uint64) uroundf((ts->frameRate() * (iTick - tick)) / tickRate); }
+        uint64 frameFromTick (uint64 iTick) const
+        {
+            if (ts->isExactMode())
+                return frame + (uint64) scaleExact ((int64) (iTick - tick), tickDen, tickNum);
+            return frame + (uint64) uroundf((ts->frameRate() * (iTick - tick)) / tickRate);
+        }
+
+		// Batch frame/tick convertors, for values at or after this node.
+        void ticksFromFrames (const uint64* frames, uint64* ticks, int numValues, Precision precision = DoublePrecision) const;
+        void framesFromTicks (const uint64* ticks, uint64* frames, int numValues, Precision precision = DoublePrecision) const;
+
+		// Exact ticks per frame, tempo * ticks per beat / (60 * sample rate).
+        void getTickFrameRatio (uint64& numerator, uint64& denominator) const;
+
+        /** Returns the tempo as an exact fraction. A float tempo is exactly
+            mantissa / 2^shift, which always fits a Rational */
+        Rational getExactTempo() const;
 
 		// Tick/beat convertors.
 		unsigned int beatFromTick(uint64 iTick) const { return beat + (unsigned int) ((iTick - tick) / ticksPerBeat); }
@@ -197,12 +247,20 @@ public:
 
 	protected:
         friend class TimeScale;
+        friend class TimeScaleSnapshot;
 		// Node owner.
 		TimeScale *ts;
 
 		// Node cached coefficients.
         float tickRate;
         float beatRate;
+
+        // Exact ticks and beats per frame, for exact mode.
+        uint64 tickNum, tickDen;
+        uint64 beatNum, beatDen;
+
+        // Position in the owner's segment index, if it is indexed.
+        int segment;
 	};
 
 	// Node list accessor.
@@ -285,6 +343,16 @@ public:
         return (node ? node->frameFromTick (tick) : 0);
 	}
 
+    /** Convert an array of frames to ticks. Consecutive values in the same
+        tempo segment are converted together, so ascending input is fastest */
+    void ticksFromFrames (const uint64* frames, uint64* ticks, int numValues,
+                          Precision precision = DoublePrecision) const;
+
+    /** Convert an array of ticks to frames. Consecutive values in the same
+        tempo segment are converted together, so ascending input is fastest */
+    void framesFromTicks (const uint64* ticks, uint64* frames, int numValues,
+                          Precision precision = DoublePrecision) const;
+
 	// Tick/pixel general converters.
     uint64 tickFromPixel (int x) const
 	{
@@ -337,6 +405,24 @@ public:
         return (node ? node->pixelSnap (x) : x);
 	}
 
+    /** A vertical grid line at a snap position */
+    struct GridLine
+    {
+        int          pixel;
+        unsigned int beat;
+        bool         isBeat;    ///< false for snap subdivisions
+        bool         isBar;
+    };
+
+    /** Returns the grid lines between two pixels, in order, built in one
+        pass over the tempo map. Lines closer than minSpacing pixels are
+        thinned: snap lines go first, then beats, then every other bar. The
+        result is cached for the current zoom and snap until the tempo map
+        changes, and covers some margin around the range so scrolling doesn't
+        rebuild it. Callers should skip lines outside the range they draw.
+        The cache isn't locked, call this from the message thread only */
+    const Array<GridLine>& getGridLines (int startPixel, int endPixel, int minSpacing = 4) const;
+
 	// Display-format accessors.
     void setDisplayFormat (DisplayFormat dfmt) { mDisplayFmt = dfmt; }
     DisplayFormat displayFormat() const { return mDisplayFmt; }
@@ -501,6 +587,8 @@ public:
 #endif
 
 protected:
+    friend class TimeScaleSnapshot;
+
 	// Tempo-map independent coefficients.
     float pixelRate() const { return mPixelRate; }
     float frameRate() const { return mFrameRate; }
@@ -515,6 +603,7 @@ private:
     unsigned int   mSampleRate;     ///< Sample rate (frames per second)
     unsigned short mTicksPerBeat;   ///< Tticks per quarter note (PPQN)
     unsigned short mPixelsPerBeat;  ///< Pixels per beat (width).
+    bool           mExactMode;      ///< Exact rational frame conversions.
 
 	// Tempo-map node list.
     LinkedList<Node> mNodes;
@@ -522,6 +611,46 @@ private:
 	// Internal node cursor.
     Cursor mCursor;
 
+    // Contiguous copy of the node keys, in list order, so cursors can
+    // binary search instead of walking the list. Entries before
+    // mNumValidSegments match the list. The mutating calls rebuild the
+    // rest before returning, so const seeks only ever read the index.
+    struct Segment
+    {
+        uint64         frame;
+        uint64         tick;
+        unsigned int   beat;
+        int            pixel;
+        unsigned short bar;
+        Node*          node;
+    };
+
+    Array<Segment> mSegments;
+    int mNumValidSegments;
+
+    /** Returns the index entry for a node */
+    static Segment segmentFor (Node* node) noexcept;
+
+    /** Drop index entries from this node onwards, nullptr drops them all */
+    void invalidateSegments (Node* from);
+
+    /** Re-index the nodes after the valid entries */
+    void rebuildSegments();
+
+    /** Returns the last node whose key is at or before value. Stale nodes
+        past the index, mid-edit, are walked instead */
+    template<typename KeyType>
+    Node* findSegment (KeyType Segment::* key, KeyType value) const;
+
+    // Grid lines from the last getGridLines call and the view they cover.
+    // Dropped with the segment index, so tempo map and zoom edits rebuild.
+    mutable Array<GridLine> mGridLines;
+    mutable Range<int> mGridRange;
+    mutable float mGridPixelRate;
+    mutable unsigned short mGridSnap;
+    mutable int mGridSpacing;
+    mutable bool mGridValid;
+
 	// Tempo-map independent coefficients.
     float mPixelRate;
     float mFrameRate;
@@ -532,3 +661,142 @@ private:
 	// Internal node cursor.
     MarkerCursor mMarkerCursor;
 };
+
+/** An immutable copy of a TimeScale's tempo map.
+
+    Conversions are const and never touch shared state, so any number of
+    threads can use one snapshot at once. Each reader passes its own Cursor,
+    which remembers the last segment so sequential lookups skip the binary
+    search. Snapshots are reference counted: hold a Ptr to keep one alive
+    from the GUI, or use RealtimeTimeScale to hand them to the audio thread. */
+class TimeScaleSnapshot : public ReferenceCountedObject
+{
+public:
+    typedef ReferenceCountedObjectPtr<TimeScaleSnapshot> Ptr;
+
+    /** Per reader seek position. Starts at the first segment and is safe to
+        reuse across snapshots */
+    struct Cursor
+    {
+        Cursor() : segment (0) { }
+        int segment;
+    };
+
+    /** Copy the tempo map of a TimeScale (editing thread) */
+    explicit TimeScaleSnapshot (const TimeScale& ts);
+
+    /** Returns the number of tempo segments, at least one */
+    inline int getNumSegments() const noexcept { return segments.size(); }
+
+    inline unsigned int getSampleRate() const noexcept  { return sampleRate; }
+    inline unsigned short ticksPerBeat() const noexcept { return ticksPerBeatResolution; }
+
+    /** True if the source TimeScale was in exact mode */
+    inline bool isExactMode() const noexcept { return exactMode; }
+
+    // Frame/tick convertors.
+    uint64 tickFromFrame (uint64 frame, Cursor& cursor) const noexcept;
+    uint64 frameFromTick (uint64 tick, Cursor& cursor) const noexcept;
+
+    /** Convert an array of ticks to frames, giving the same results as
+        frameFromTick. Values in the same segment share one seek */
+    void framesFromTicks (const uint64* ticks, uint64* frames, int numValues, Cursor& cursor) const noexcept;
+
+    // Frame/beat convertors.
+    unsigned int beatFromFrame (uint64 frame, Cursor& cursor) const noexcept;
+    uint64 frameFromBeat (unsigned int beat, Cursor& cursor) const noexcept;
+
+    // Frame/bar convertors.
+    unsigned short barFromFrame (uint64 frame, Cursor& cursor) const noexcept;
+    uint64 frameFromBar (unsigned short bar, Cursor& cursor) const noexcept;
+
+    // Tick/pixel convertors.
+    int pixelFromTick (uint64 tick, Cursor& cursor) const noexcept;
+    uint64 tickFromPixel (int x, Cursor& cursor) const noexcept;
+
+    // Frame/pixel convertors.
+    int pixelFromFrame (int64_t frame) const noexcept { return (int) TimeScale::roundf ((pixelRate * frame) / frameRate); }
+    int64_t frameFromPixel (int x) const noexcept { return TimeScale::roundf ((frameRate * x) / pixelRate); }
+
+    /** Returns the tempo in effect at a frame */
+    float getTempoAtFrame (uint64 frame, Cursor& cursor) const noexcept;
+
+    /** Returns the beats per bar in effect at a frame */
+    unsigned short getBeatsPerBarAtFrame (uint64 frame, Cursor& cursor) const noexcept;
+
+private:
+    // The keys and coefficients of one TimeScale::Node
+    struct Segment
+    {
+        uint64         frame;
+        uint64         tick;
+        unsigned int   beat;
+        int            pixel;
+        unsigned short bar;
+
+        float          tempo;
+        unsigned short beatsPerBar;
+        unsigned short ticksPerBeat;
+        float          tickRate;
+        float          beatRate;
+        uint64         tickNum, tickDen;
+        uint64         beatNum, beatDen;
+    };
+
+    Array<Segment> segments;
+    float frameRate, pixelRate;
+    unsigned int sampleRate;
+    unsigned short ticksPerBeatResolution;
+    bool exactMode;
+
+    template<typename KeyType>
+    const Segment& seek (KeyType Segment::* key, KeyType value, Cursor& cursor) const noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE (TimeScaleSnapshot)
+};
+
+/** Hands TimeScaleSnapshots from an editing thread to the audio thread.
+
+    publish() takes a snapshot and swaps it in. The audio thread calls
+    acquire() at the start of each block. Like RealtimeMatrixState, slots
+    are triple buffered so neither side waits, and references are only
+    ever dropped by publish(), so the audio thread never frees a snapshot.
+    Only one thread may publish. */
+class RealtimeTimeScale
+{
+public:
+    RealtimeTimeScale() : middle (1), back (2), front (0) { }
+
+    /** Publish the current state of a TimeScale (editing thread).
+        Allocates, not realtime safe */
+    void publish (const TimeScale& ts);
+
+    /** Publish an existing snapshot (editing thread) */
+    void publish (TimeScaleSnapshot* snapshot);
+
+    /** Returns the most recently published snapshot (editing thread) */
+    TimeScaleSnapshot::Ptr getLatest() const { return latest; }
+
+    /** Returns the newest published snapshot, or nullptr before the first
+        publish (audio thread). Lock free and realtime safe. The snapshot
+        stays valid until the next acquire() */
+    const TimeScaleSnapshot* acquire() noexcept
+    {
+        if (middle.load (std::memory_order_relaxed) & newFlag)
+            front = middle.exchange (front, std::memory_order_acq_rel) & indexMask;
+        return slots [front].get();
+    }
+
+    /** Returns true if a snapshot was published since the last acquire() */
+    bool hasNewSnapshot() const noexcept { return (middle.load (std::memory_order_relaxed) & newFlag) != 0; }
+
+private:
+    enum { indexMask = 3, newFlag = 4 };
+    TimeScaleSnapshot::Ptr slots [3];
+    TimeScaleSnapshot::Ptr latest;
+    std::atomic<int> middle;    ///< index of the slot between the threads, plus newFlag
+    int back;                   ///< writer's slot
+    int front;                  ///< reader's slot
+
+    JUCE_DECLARE_NON_COPYABLE (RealtimeTimeScale)
+};
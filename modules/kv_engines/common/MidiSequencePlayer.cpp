@@ -97,40 +97,69 @@ double MidiSequencePlayer::getLoopBeatPosition() const
     return shuttle->getPositionBeats() - static_cast<double> (getLoopRepeatIndex() * getBeatLength());
 }
 
-namespace Midi {
-
-
-void renderSequence (MidiBuffer& target, const MidiMessageSequence& seq, const TimeScale& ts,
-                     int32 startFrame, int32 numSamples)
+namespace MidiSequencePlayerHelpers {
+
+/** Adds the events of a sequence that land in a block. The events
+    between the block's first and last ticks are converted to frames
+    together by framesFromTicks (const uint64* ticks, uint64* frames, int n) */
+template<class FramesFromTicks>
+static void renderEvents (MidiBuffer& target, const MidiMessageSequence& seq, uint64 startTick, uint64 endTick,
+                          int32 startFrame, int32 numSamples, FramesFromTicks framesFromTicks)
 {
-#if 1
+    enum { batchSize = 64 };
+    uint64 ticks [batchSize], frames [batchSize];
+
+    // The block's ticks are rounded, so take a tick either side. Events that
+    // map outside the block are dropped below, the neighbours play them
     const int32 numEvents = seq.getNumEvents();
-    const double start = (double) ts.tickFromFrame (startFrame);
-    for (int32 i = seq.getNextIndexAtTime (start); i < numEvents;)
+    int32 i = seq.getNextIndexAtTime ((double) (startTick > 0 ? startTick - 1 : 0));
+    while (i < numEvents)
     {
-        const auto* const ev = seq.getEventPointer (i);
-        const double tick = ev->message.getTimeStamp();
-        const int frameInSeq = (int) ts.frameFromTick (static_cast<unsigned long> (tick));
-        const int timeStamp = frameInSeq - startFrame;
+        int numTicks = 0;
+        while (numTicks < batchSize && i + numTicks < numEvents)
+        {
+            const uint64 tick = static_cast<uint64> (seq.getEventPointer (i + numTicks)->message.getTimeStamp());
+            if (tick > endTick + 1)
+                break;
+            ticks [numTicks++] = tick;
+        }
 
-        if (timeStamp >= numSamples)
+        if (numTicks == 0)
             break;
 
-        target.addEvent (ev->message, timeStamp);
-
-        /* if (ev->message.isNoteOn())
-         {
-         const double ots = ev->noteOffObject->message.getTimeStamp() / (double) Shuttle::PPQ;
-         if (ots >= (double) getBeatLength())
-         {
-         ts.frameFromTick (static_cast<unsigned long> (ots * (double) Shuttle::PPQ));
-         }
-         }
-         */
+        framesFromTicks (ticks, frames, numTicks);
+        for (int j = 0; j < numTicks; ++j)
+        {
+            const int timeStamp = (int) frames[j] - startFrame;
+            if (timeStamp >= 0 && timeStamp < numSamples)
+                target.addEvent (seq.getEventPointer (i + j)->message, timeStamp);
+        }
 
-        ++i;
+        i += numTicks;
     }
-#endif
+}
+
+}
+
+namespace Midi {
+
+void renderSequence (MidiBuffer& target, const MidiMessageSequence& seq, const TimeScale& ts,
+                     int32 startFrame, int32 numSamples)
+{
+    const TimeScale::Precision precision = ts.isExactMode() ? TimeScale::RationalPrecision : TimeScale::DoublePrecision;
+    const uint64 startTick = ts.tickFromFrame ((uint64) startFrame);
+    const uint64 endTick   = ts.tickFromFrame ((uint64) (startFrame + numSamples));
+    MidiSequencePlayerHelpers::renderEvents (target, seq, startTick, endTick, startFrame, numSamples,
+        [&ts, precision] (const uint64* ticks, uint64* frames, int numTicks) { ts.framesFromTicks (ticks, frames, numTicks, precision); });
+}
+
+void renderSequence (MidiBuffer& target, const MidiMessageSequence& seq, const TimeScaleSnapshot& ts,
+                     TimeScaleSnapshot::Cursor& cursor, int32 startFrame, int32 numSamples)
+{
+    const uint64 startTick = ts.tickFromFrame ((uint64) startFrame, cursor);
+    const uint64 endTick   = ts.tickFromFrame ((uint64) (startFrame + numSamples), cursor);
+    MidiSequencePlayerHelpers::renderEvents (target, seq, startTick, endTick, startFrame, numSamples,
+        [&ts, &cursor] (const uint64* ticks, uint64* frames, int numTicks) { ts.framesFromTicks (ticks, frames, numTicks, cursor); });
 }
 
 }
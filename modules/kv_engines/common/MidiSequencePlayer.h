@@ -25,6 +25,11 @@ class TimeScale;
 
 namespace Midi {
     void renderSequence (MidiBuffer& target, const MidiMessageSequence& seq, const TimeScale& ts, int32 startFrame, int32 numSamples);
+
+    /** Render from a tempo map snapshot. Safe on the audio thread while the
+        editor changes the TimeScale the snapshot came from */
+    void renderSequence (MidiBuffer& target, const MidiMessageSequence& seq, const TimeScaleSnapshot& ts,
+                         TimeScaleSnapshot::Cursor& cursor, int32 startFrame, int32 numSamples);
 }
 
 /** A single track midi sequencer with record functionality */
@@ -31,11 +31,20 @@ uint32 Processor::getNumPorts (AudioProcessor* proc)
 
 uint32 Processor::getNumPorts (AudioProcessor* proc, PortType type, bool isInput)
 {
-    uint32 count = 0;
-    for (uint32 port = 0; port < getNumPorts(proc); ++port)
-        if (isInput == isPortInput (proc, port) && type == getPortType (proc, port))
-            ++count;
-    return count;
+    // ports are laid out as audio ins, audio outs, controls, midi in, midi out
+    switch (type.id())
+    {
+        case PortType::Audio:
+            return (uint32) (isInput ? proc->getTotalNumInputChannels() : proc->getTotalNumOutputChannels());
+        case PortType::Control:
+            return isInput ? (uint32) proc->getNumParameters() : 0;
+        case PortType::Midi:
+            return (isInput ? proc->acceptsMidi() : proc->producesMidi()) ? 1 : 0;
+        default:
+            break;
+    }
+
+    return 0;
 }
 
 PortType Processor::getPortType (AudioProcessor* proc, uint32 p)
@@ -108,6 +117,9 @@ int Processor::getChannelPort (uint32 port)
 {
     jassert (port < (uint32) getNumPorts());
 
+    if (channelMapValid)
+        return channelMap.getChannel (port);
+
     int channel = 0;
 
     const bool isInput  = isPortInput (port);
@@ -141,6 +153,13 @@ uint32 Processor::getNumPorts (PortType type, bool isInput)
 
 uint32 Processor::getNthPort (PortType type, int index, bool isInput, bool oneBased)
 {
+    if (channelMapValid)
+    {
+        const uint32 port = channelMap.getPort (type, oneBased ? index - 1 : index, isInput);
+        jassert (port != KV_INVALID_PORT);
+        return port;
+    }
+
     int count = oneBased ? 0 : -1;
 
     jassert (getNumPorts() >= 0);
@@ -160,6 +179,40 @@ uint32 Processor::getNthPort (PortType type, int index, bool isInput, bool oneBa
     return KV_INVALID_PORT;
 }
 
+void Processor::numChannelsChanged()
+{
+    refreshChannelMap();
+}
+
+void Processor::refreshChannelMap()
+{
+    const uint32 numPorts = getNumPorts();
+    Array<PortType> types;
+    Array<bool> inputs;
+    types.ensureStorageAllocated ((int) numPorts);
+    inputs.ensureStorageAllocated ((int) numPorts);
+
+    for (uint32 port = 0; port < numPorts; ++port)
+    {
+        types.add (getPortType (port));
+        inputs.add (isPortInput (port));
+    }
+
+    ChannelMap newMap (types, inputs);
+
+    // the same total can hide a different layout, so every type must match
+    bool valid = numPorts > 0;
+    for (int type = 0; valid && type < PortType::Unknown; ++type)
+        valid = (uint32) newMap.getNumChannels (type, true) == getNumPorts (type, true)
+             && (uint32) newMap.getNumChannels (type, false) == getNumPorts (type, false);
+
+    {
+        const ScopedLock sl (getCallbackLock());
+        channelMap.swapWith (newMap);
+        channelMapValid = valid;
+    }
+}
+
 bool Processor::isPortInput (uint32 port)
 {
     return isPortInput (this, port);
@@ -23,7 +23,7 @@ class Processor :  public AudioPluginInstance
 {
 
 public:
-    Processor() { }
+    Processor() : channelMapValid (false) { }
     virtual ~Processor() { }
 
     /** Returns a channel index for a given port */
@@ -53,10 +53,34 @@ public:
 
     bool writeControlValue (uint32 port, float value);
 
+    /** Rebuild the port/channel lookup from getPortType and isPortInput.
+
+        This is called when the channel layout changes. Call it yourself
+        whenever other ports change, e.g. parameters, otherwise lookups keep
+        answering from the old layout. The map is validated against
+        getNumPorts here, and if any type's count differs getNthPort and
+        getChannelPort scan every port instead.
+
+        The new map is built first and then swapped in while holding
+        getCallbackLock(), so a processBlock() in progress never sees it
+        change. Don't call it while other threads outside the audio
+        callback are looking up ports. */
+    void refreshChannelMap();
+
+    /** Refreshes the channel map */
+    void numChannelsChanged() override;
+
+    /** Returns the lookup built by refreshChannelMap */
+    inline const ChannelMap& getChannelMap() const noexcept { return channelMap; }
+
     static uint32 getPortForAudioChannel (AudioProcessor*, int, bool);
     static uint32 getNumPorts (AudioProcessor*);
     static uint32 getNumPorts (AudioProcessor*, PortType type, bool isInput);
     static PortType getPortType (AudioProcessor*, uint32 port);
     static bool isPortInput (AudioProcessor*, uint32 port);
     static bool writeToPort (AudioProcessor*, uint32 port, uint32 size, uint32 protocol, void const* data);
+
+private:
+    ChannelMap channelMap;
+    bool channelMapValid;
 };
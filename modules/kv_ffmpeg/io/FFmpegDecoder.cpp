@@ -504,7 +504,8 @@ public:
     {
         while (! threadShouldExit())
         {
-            sem.wait();
+            if (! sem.timedWait (100))
+                continue;
             
             if (threadShouldExit())
                 break;
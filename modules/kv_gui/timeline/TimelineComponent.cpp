@@ -147,6 +147,7 @@ TimelineComponent::TimelineComponent()
     freeClips.clear();
     clips.clear();
     pixelOffset = 0;
+    gridVisible = false;
     heights.ensureTracks (512, TrackHeights::Mini);
     heights.setOffset (0);
 
@@ -296,39 +297,42 @@ void TimelineComponent::paint (Graphics& g)
     }
 #endif
 
-#if 0
-    // paint grid lines
+    if (gridVisible)
+        paintGridLines (g);
+}
+
+void TimelineComponent::paintGridLines (Graphics& g)
+{
     g.saveState();
-    g.setColour (Colours::white);
+    g.reduceClipRegion (mTrackWidth, 0, getWidth() - mTrackWidth, getHeight());
 
-    for (int beat = scale.beatFromPixel (timeToX (timeSpan.getStart())) - 1;
-         ++beat;)
+    const int gridStart = -pixelOffset;
+    const Array<TimeScale::GridLine>& lines (scale.getGridLines (gridStart, gridStart + getWidth() - mTrackWidth));
+    for (int i = 0; i < lines.size(); ++i)
     {
-        const int pixel = scale.pixelFromBeat (beat) + mTrackWidth;
+        const TimeScale::GridLine& line (lines.getReference (i));
+        const int pixel = line.pixel + mTrackWidth + pixelOffset;
 
-        if (pixel < 0)
+        if (pixel < mTrackWidth)
             continue;
+        if (pixel > getWidth())
+            break;
 
-        if (scale.beatIsBar (beat))
+        if (line.isBar)
         {
-            g.saveState();
-            g.setColour(Colours::white);
-            g.drawText (String(beat), pixel, 0, 20, 16, Justification::left, true);
-            g.restoreState();
-            g.setOpacity (0.20);
+            g.setColour (Colours::white);
+            g.drawText (String (line.beat), pixel, 0, 20, 16, Justification::left, true);
+            g.setColour (Colours::white.withAlpha (0.20f));
         }
         else
-            g.setOpacity (0.10);
+        {
+            g.setColour (Colours::white.withAlpha (line.isBeat ? 0.10f : 0.05f));
+        }
 
         g.drawVerticalLine (pixel, 0, getHeight());
-
-        if (pixel > getWidth())
-            break;
     }
 
     g.restoreState();
-    g.resetToDefaultState();
-#endif
 
 }
 
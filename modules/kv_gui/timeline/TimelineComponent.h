@@ -169,6 +169,17 @@ public:
 
     const TimeScale& timeScale() const { return scale; }
 
+    /** Show bar, beat and snap lines behind the clips. Off by default */
+    inline void setGridVisible (bool visible)
+    {
+        if (gridVisible == visible)
+            return;
+        gridVisible = visible;
+        repaint();
+    }
+
+    inline bool isGridVisible() const { return gridVisible; }
+
     void paint (Graphics& g) override;
     void paintOverChildren (Graphics& g) override;
     void resized() override;
@@ -330,6 +341,7 @@ private:
     double timeOffset;
     int pixelOffset, dragX, dragY;
     double pixPerUnit;
+    bool gridVisible;
 
     OwnedArray<TimelineClip> clips, freeClips;
 
@@ -340,6 +352,8 @@ private:
     friend class AsyncUpdater;
     void handleAsyncUpdate() override;
 
+    void paintGridLines (Graphics& g);
+
     void normalX (int32& x) const
     {
         x -= mTrackWidth;